@@ -6,7 +6,12 @@
 #include "Commands.h"
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 #include "Utils.h"
+#include "SurfaceContext.h"
+#include "TrackNameCache.h"
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #ifdef __APPLE__
     #define strcpy_s(dest,dest_sz, src) strlcpy(dest,src, dest_sz)
@@ -15,7 +20,7 @@
     #define REAKONTROL_INI "\\UserPlugins\\ReaKontrolConfig\\reakontrol.ini"
 #endif
 
-aList g_actionList;
+ActionTable g_actionList;
 bool g_actionListLoaded = false; // action list will be populated from ini file after successful connection to allow Reaper main thread to load all extensions first
 
 std::string toLowerTrimmed(const char* str) {
@@ -26,27 +31,129 @@ std::string toLowerTrimmed(const char* str) {
     return result;
 }
 
+namespace {
+    // Modification time and size of the ini file when it was last read
+    struct ConfigFileStamp {
+        bool exists = false;
+        long long mtime = 0;
+        long long size = 0;
+
+        bool operator==(const ConfigFileStamp& other) const {
+            return exists == other.exists && mtime == other.mtime && size == other.size;
+        }
+    };
+
+    ConfigFileStamp g_configStamp;
+    bool g_configStampValid = false;
+
+    ConfigFileStamp statConfigFile(const char* pathname) {
+        ConfigFileStamp stamp;
+#ifdef _WIN32
+        // REAPER paths are UTF-8
+        wchar_t widePath[1024];
+        struct _stat64 st;
+        if (MultiByteToWideChar(CP_UTF8, 0, pathname, -1, widePath, sizeof(widePath) / sizeof(widePath[0])) &&
+            _wstat64(widePath, &st) == 0) {
+#else
+        struct stat st;
+        if (stat(pathname, &st) == 0) {
+#endif
+            stamp.exists = true;
+            stamp.mtime = static_cast<long long>(st.st_mtime);
+            stamp.size = static_cast<long long>(st.st_size);
+        }
+        return stamp;
+    }
+
+    constexpr int MAX_ACTIONS = 64 * BANK_NUM_TRACKS;
+
+    // Display messages of every page: slot states, names and knobs, bank lights for paging, cleared meters
+    void encodePages(ActionTable& actions) {
+        static const char clearPeak[(BANK_NUM_TRACKS * 2) + 1] = { 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,0 };
+        int numPages = static_cast<int>(actions.commands.size() / BANK_NUM_TRACKS);
+        actions.pages.assign(numPages, std::vector<unsigned char>());
+        for (int page = 0; page < numPages; ++page) {
+            std::vector<unsigned char>& out = actions.pages[page];
+            int bankLights = (page > 0 ? 1 : 0) | (page + 1 < numPages ? 2 : 0); // left / right
+            MidiSender::encodeCc(out, CMD_NAV_BANKS, static_cast<unsigned char>(bankLights));
+            for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+                size_t index = static_cast<size_t>(page) * BANK_NUM_TRACKS + i;
+                unsigned char slot = static_cast<unsigned char>(i);
+                bool used = actions.commands[index] > 0;
+                MidiSender::encodeSysex(out, CMD_TRACK_AVAIL, used ? TRTYPE_MIDI : 0, slot);
+                if (!used) {
+                    // Solo lights of actions follow their toggle state, see updateActionToggles()
+                    MidiSender::encodeSysex(out, CMD_TRACK_SOLOED, 0, slot);
+                }
+                MidiSender::encodeSysex(out, CMD_TRACK_MUTED_BY_SOLO, 0, slot);
+                MidiSender::encodeSysex(out, CMD_TRACK_MUTED, 0, slot);
+                MidiSender::encodeSysex(out, CMD_TRACK_ARMED, 0, slot);
+                MidiSender::encodeSysex(out, CMD_TRACK_SELECTED, 0, slot);
+                if (used) {
+                    const std::string& name = actions.names[index];
+                    MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, slot, name.empty() ? "NAME?" : name);
+                    MidiSender::encodeSysex(out, CMD_TRACK_VOLUME_TEXT, 0, slot, "Action");
+                    MidiSender::encodeSysex(out, CMD_TRACK_PAN_TEXT, 0, slot, "Action");
+                }
+                else {
+                    MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, slot, "");
+                    MidiSender::encodeSysex(out, CMD_TRACK_VOLUME_TEXT, 0, slot, " ");
+                    MidiSender::encodeSysex(out, CMD_TRACK_PAN_TEXT, 0, slot, " ");
+                }
+                MidiSender::encodeCc(out, CMD_KNOB_VOLUME0 + slot, 1);
+                MidiSender::encodeCc(out, CMD_KNOB_PAN0 + slot, 63);
+            }
+            if (actions.configMissing && page == 0) {
+                MidiSender::encodeSysex(out, CMD_TRACK_AVAIL, TRTYPE_MIDI, 0);
+                MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, 0, "Config file not found!");
+            }
+            MidiSender::encodeSysex(out, CMD_TRACK_VU, 2, 0, clearPeak);
+        }
+    }
+
+    // Single empty page pointing to the missing configuration file
+    void setConfigMissing() {
+        ActionTable actions;
+        actions.commands.assign(BANK_NUM_TRACKS, 0);
+        actions.names.assign(BANK_NUM_TRACKS, std::string());
+        actions.configMissing = true;
+        encodePages(actions);
+        g_actionList = std::move(actions);
+    }
+}
+
+std::string configFilePath(const std::string& resourcePath) {
+    return resourcePath + REAKONTROL_INI;
+}
+
 void loadConfigFile() {
-    const char* pathname = GetResourcePath();
-    std::string s_filename(pathname);
-    s_filename += REAKONTROL_INI;
+    std::string s_filename = configFilePath(GetResourcePath());
     s_filename.push_back('\0');
-    pathname = &s_filename[0];
+    const char* pathname = &s_filename[0];
+
+    // Called on every return to normal mode: only read the file again if it was edited since
+    ConfigFileStamp stamp = statConfigFile(pathname);
+    if (g_configStampValid && stamp == g_configStamp) {
+        return;
+    }
+    debugLog("Refreshed Configs");
 
     // Add default ini
-    if (!file_exists(pathname)) {
+    if (!stamp.exists) {
         WritePrivateProfileString("reakontrol_actions", "action_0_id", "40001", pathname);
         if (!WritePrivateProfileString("reakontrol_actions", "action_0_name", "Insert Default Track", pathname)) {
             std::ostringstream s;
             s << "Unable to write configuration file! Please read manual, subfolder must exist for the configuration file:\n\n"
               << s_filename;
             ShowMessageBox(s.str().c_str(), "ReaKontrol", 0);
-            g_actionList.ID[0] = -1;
+            setConfigMissing();
         }
     }
 
     // Read ini
-    if (file_exists(pathname)) {
+    g_configStamp = statConfigFile(pathname);
+    g_configStampValid = true;
+    if (g_configStamp.exists) {
         loadReaKontrolSettings(pathname);
         loadActions(pathname);
     } else {
@@ -54,7 +161,7 @@ void loadConfigFile() {
         s << "Komplete Kontrol Keyboard successfully connected but configuration file not found! Please read manual how to configure custom actions via the configuration file:\n\n"
           << s_filename;
         ShowMessageBox(s.str().c_str(), "ReaKontrol", 0);
-        g_actionList.ID[0] = -1;
+        setConfigMissing();
     }
 }
 
@@ -64,97 +171,109 @@ void loadReaKontrolSettings(const std::string& iniPath) {
 
     std::string val = toLowerTrimmed(buffer);
     g_debugLogging = (val == "true" || val == "1");*/
+
+    GetPrivateProfileString("settings", "selection_debounce_ms", "", buffer, sizeof(buffer), iniPath.c_str());
+    std::string debounce = toLowerTrimmed(buffer);
+    g_selectionDebounceMs = SELECTION_DEBOUNCE_MS;
+    if (!debounce.empty()) {
+        int ms = atoi(debounce.c_str());
+        if (ms >= 0 && ms <= 2000) {
+            g_selectionDebounceMs = ms;
+        }
+    }
+
+    // Bank filters, the surfaces' bank layouts pick up a change on their next lookup
+    GetPrivateProfileString("settings", "bank_skip_hidden", "", buffer, sizeof(buffer), iniPath.c_str());
+    std::string skipHidden = toLowerTrimmed(buffer);
+    g_bankSkipHidden = !(skipHidden == "false" || skipHidden == "0");
+    GetPrivateProfileString("settings", "bank_skip_collapsed", "", buffer, sizeof(buffer), iniPath.c_str());
+    std::string skipCollapsed = toLowerTrimmed(buffer);
+    g_bankSkipCollapsed = !(skipCollapsed == "false" || skipCollapsed == "0");
+    GetPrivateProfileString("settings", "bank_max_depth", "", buffer, sizeof(buffer), iniPath.c_str());
+    std::string maxDepth = toLowerTrimmed(buffer);
+    g_bankMaxDepth = maxDepth.empty() ? -1 : std::max(-1, atoi(maxDepth.c_str()));
 }
 
 void loadActions(const char* pathname)
 {
-    std::string s_keyName;
-    char* key;
+    // Parse into a new table and replace the current one as a whole, so a half read or partly invalid file never
+    // mixes with the previous actions
+    ActionTable actions;
     char stringOut[128] = {};
-    int stringOut_sz = sizeof(stringOut);
-
-    for (int i = 0; i <= 7; ++i) {
-        s_keyName = "action_" + std::to_string(i) + "_ID";
-        s_keyName.push_back('\0');
-        key = &s_keyName[0];
-        GetPrivateProfileString("reakontrol_actions", key, nullptr, stringOut, stringOut_sz, pathname);
-
-        if (stringOut[0] != '\0') {
-            g_actionList.ID[i] = NamedCommandLookup(stringOut);
-            if (g_actionList.ID[i]) {
-                s_keyName = "action_" + std::to_string(i) + "_name";
-                s_keyName.push_back('\0');
-                key = &s_keyName[0];
-                GetPrivateProfileString("reakontrol_actions", key, nullptr, stringOut, stringOut_sz, pathname);
-                if (stringOut[0] != '\0') {
-                    strcpy_s(g_actionList.name[i], 128, stringOut);
-                }
-                else {
-                    g_actionList.name[i][0] = '\0';
-                }
-            }
+    int gap = 0;
+
+    // Slots may be left empty, the list ends after a whole page of them
+    for (int i = 0; i < MAX_ACTIONS && gap < BANK_NUM_TRACKS; ++i) {
+        std::string keyName = "action_" + std::to_string(i) + "_ID";
+        stringOut[0] = '\0';
+        GetPrivateProfileString("reakontrol_actions", keyName.c_str(), nullptr, stringOut, sizeof(stringOut), pathname);
+        int command = (stringOut[0] != '\0') ? NamedCommandLookup(stringOut) : 0;
+        std::string name;
+        if (command > 0) {
+            keyName = "action_" + std::to_string(i) + "_name";
+            stringOut[0] = '\0';
+            GetPrivateProfileString("reakontrol_actions", keyName.c_str(), nullptr, stringOut, sizeof(stringOut), pathname);
+            name = toDisplayName(stringOut, TRACK_NAME_MAX_CHARS);
+            gap = 0;
         }
         else {
-            g_actionList.ID[i] = 0;
-            g_actionList.name[i][0] = '\0';
+            command = 0;
+            ++gap;
         }
+        actions.commands.push_back(command);
+        actions.names.push_back(name);
     }
+    // Drop the trailing empty slots, but keep whole pages
+    size_t used = actions.commands.size() - gap;
+    size_t slots = ((used + BANK_NUM_TRACKS - 1) / BANK_NUM_TRACKS) * BANK_NUM_TRACKS;
+    if (slots == 0) slots = BANK_NUM_TRACKS;
+    actions.commands.resize(slots, 0);
+    actions.names.resize(slots);
+    encodePages(actions);
+    g_actionList = std::move(actions);
 }
 
-void showActionList(MidiSender* midiSender) {
-    static char clearPeak[(BANK_NUM_TRACKS * 2) + 1] = { 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,0 };
-    if (!midiSender) return;
+void showActionList(MidiSender* midiSender, int page) {
+    if (!midiSender || g_actionList.pages.empty()) return;
     debugLog("showActionList");
-    midiSender->sendCc(CMD_NAV_BANKS, 0);
-    for (int i = 0; i <= 7; ++i) {
-        if (g_actionList.ID[i] > 0) {
-            midiSender->sendSysex(CMD_TRACK_AVAIL, TRTYPE_MIDI, i);
-            midiSender->sendSysex(CMD_TRACK_SOLOED, 1, i);
-            midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, 0, i);
-            midiSender->sendSysex(CMD_TRACK_MUTED, 0, i);
-            midiSender->sendSysex(CMD_TRACK_ARMED, 0, i);
-            midiSender->sendSysex(CMD_TRACK_SELECTED, 0, i);
-            if (g_actionList.name[i][0] == '\0') {
-                midiSender->sendSysex(CMD_TRACK_NAME, 0, i, "NAME?");
-            } else {
-                midiSender->sendSysex(CMD_TRACK_NAME, 0, i, &g_actionList.name[i][0]);
-            }
-            midiSender->sendSysex(CMD_TRACK_VOLUME_TEXT, 0, i, "Action");
-            midiSender->sendSysex(CMD_TRACK_PAN_TEXT, 0, i, "Action");
-            midiSender->sendCc((CMD_KNOB_VOLUME0 + i), 1);
-            midiSender->sendCc((CMD_KNOB_PAN0 + i), 63);
-        } else {
-            midiSender->sendSysex(CMD_TRACK_AVAIL, 0, i);
-            midiSender->sendSysex(CMD_TRACK_SOLOED, 0, i);
-            midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, 0, i);
-            midiSender->sendSysex(CMD_TRACK_MUTED, 0, i);
-            midiSender->sendSysex(CMD_TRACK_ARMED, 0, i);
-            midiSender->sendSysex(CMD_TRACK_SELECTED, 0, i);
-            midiSender->sendSysex(CMD_TRACK_NAME, 0, i, "");
-            midiSender->sendSysex(CMD_TRACK_VOLUME_TEXT, 0, i, " ");
-            midiSender->sendSysex(CMD_TRACK_PAN_TEXT, 0, i, " ");
-            midiSender->sendCc((CMD_KNOB_VOLUME0 + i), 1);
-            midiSender->sendCc((CMD_KNOB_PAN0 + i), 63);
-        }
-    }
+    page = std::max(0, std::min(page, g_actionList.pageCount() - 1));
+    midiSender->sendEncoded(g_actionList.pages[page]);
+    updateActionToggles(midiSender, page);
+}
 
-    if (g_actionList.ID[0] == -1) {
-        midiSender->sendSysex(CMD_TRACK_AVAIL, TRTYPE_MIDI, 0);
-        midiSender->sendSysex(CMD_TRACK_NAME, 0, 0, "Config file not found!");
+void updateActionToggles(MidiSender* midiSender, int page) {
+    if (!midiSender || page < 0 || page >= g_actionList.pageCount()) return;
+    // Only the shown page is polled, the cost doesn't grow with the number of pages
+    std::vector<unsigned char> frames;
+    for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+        size_t index = static_cast<size_t>(page) * BANK_NUM_TRACKS + i;
+        int command = g_actionList.commands[index];
+        if (command <= 0) continue;
+        int state = GetToggleCommandState(command); // -1: no toggle action
+        MidiSender::encodeSysex(frames, CMD_TRACK_SOLOED, (state == 0) ? 0 : 1, static_cast<unsigned char>(i));
     }
-    midiSender->sendSysex(CMD_TRACK_VU, 2, 0, clearPeak);
+    // Skips what the display already shows
+    midiSender->sendEncoded(frames);
 }
 
-void callAction(unsigned char actionSlot, MidiSender* midiSender) {
-    auto command = g_actionList.ID[actionSlot];
-    auto name = g_actionList.name[actionSlot];
-    if (command) {
+void callAction(SurfaceContext& ctx, unsigned char actionSlot, MidiSender* midiSender) {
+    // The slot comes straight from the keyboard, don't trust it to be within the action list
+    if (actionSlot >= BANK_NUM_TRACKS) return;
+    size_t index = static_cast<size_t>(ctx.actionPage) * BANK_NUM_TRACKS + actionSlot;
+    if (index >= g_actionList.commands.size()) return;
+    int command = g_actionList.commands[index];
+    const std::string& name = g_actionList.names[index];
+    if (command > 0) {
         Main_OnCommand(command, 0);
         // We need to turn off edit mode because some action will cause kkinstance taking control
         // Check if name contains "Tuner" or "Track"
-        if (strstr(name, "Tuner") || strstr(name, "Track")) {
-            setExtEditMode(EXT_EDIT_OFF);
-            allMixerUpdate(midiSender);
+        if (name.find("Tuner") != std::string::npos || name.find("Track") != std::string::npos) {
+            ctx.setExtEditMode(EXT_EDIT_OFF);
+            allMixerUpdate(ctx, midiSender);
+        }
+        else {
+            // Immediate feedback for toggle actions instead of waiting for the next poll
+            updateActionToggles(midiSender, ctx.actionPage);
         }
     }
-}
\ No newline at end of file
+}
@@ -1,17 +1,32 @@
 #pragma once
+#include <string>
+#include <vector>
 #include "MidiSender.h"
 
+struct SurfaceContext;
 
-struct aList {
-    int ID[8];
-    char name[8][128];
+
+// Actions of extended edit mode, in pages of BANK_NUM_TRACKS slots. Command IDs are resolved and the display messages
+// of every page are encoded when the ini file is read, paging only sends the stored bytes.
+struct ActionTable {
+    std::vector<int> commands; // 0 = empty slot
+    std::vector<std::string> names;
+    std::vector<std::vector<unsigned char>> pages;
+    bool configMissing = false;
+
+    int pageCount() const { return static_cast<int>(pages.size()); }
 };
 
-extern aList g_actionList;
+extern ActionTable g_actionList;
 extern bool g_actionListLoaded;
 
+// reakontrol.ini in the REAPER resource directory resourcePath
+std::string configFilePath(const std::string& resourcePath);
 void loadConfigFile();
 void loadReaKontrolSettings(const std::string& iniPath);
 void loadActions(const char* pathname);
-void showActionList(MidiSender* midiSender);
-void callAction(unsigned char actionSlot, MidiSender* midiSender);
+void showActionList(MidiSender* midiSender, int page = 0);
+// Polls the toggle state of the actions on page, the solo light of a slot is on unless its action is toggled off.
+// Only what the keyboard doesn't show yet is sent (display shadow of midiSender), so every keyboard follows on its own.
+void updateActionToggles(MidiSender* midiSender, int page);
+void callAction(SurfaceContext& ctx, unsigned char actionSlot, MidiSender* midiSender);
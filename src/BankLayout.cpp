@@ -0,0 +1,66 @@
+#include <climits>
+#include "BankLayout.h"
+#include "Constants.h"
+#include "reaKontrol.h"
+
+int BankLayout::size() {
+    update();
+    return static_cast<int>(ids.size());
+}
+
+int BankLayout::trackAt(int pos) {
+    update();
+    return (pos >= 0 && pos < static_cast<int>(ids.size())) ? ids[pos] : -1;
+}
+
+int BankLayout::positionOf(int id) {
+    int pos = rankOf(id);
+    return (pos < static_cast<int>(ids.size()) && ids[pos] == id) ? pos : -1;
+}
+
+int BankLayout::rankOf(int id) {
+    update();
+    if (id < 0) return 0;
+    return (id < static_cast<int>(ranks.size())) ? ranks[id] : static_cast<int>(ids.size());
+}
+
+BankLayout::Filter BankLayout::currentFilter() {
+    Filter current;
+    current.skipHidden = g_bankSkipHidden;
+    current.skipCollapsed = g_bankSkipCollapsed;
+    current.maxDepth = g_bankMaxDepth;
+    return current;
+}
+
+void BankLayout::update() {
+    Filter current = currentFilter();
+    if (!dirty && !(current != filter)) return;
+    filter = current;
+    dirty = false;
+    ++rebuilds;
+
+    int numTracks = CSurf_NumTracks(false);
+    ids.clear();
+    ranks.assign(numTracks + 1, 0);
+    ids.push_back(0); // master
+    int depth = 0;
+    int collapsedDepth = INT_MAX; // tracks deeper than this are children of a collapsed folder
+    for (int id = 1; id <= numTracks; ++id) {
+        ranks[id] = static_cast<int>(ids.size());
+        MediaTrack* track = CSurf_TrackFromID(id, false);
+        if (!track) continue;
+        bool eligible = !(filter.skipHidden && GetMediaTrackInfo_Value(track, "B_SHOWINMIXER") == 0.0) &&
+            !(filter.skipCollapsed && depth > collapsedDepth) && !(filter.maxDepth >= 0 && depth > filter.maxDepth);
+        if (eligible) {
+            ids.push_back(id);
+        }
+        int folderDepth = static_cast<int>(GetMediaTrackInfo_Value(track, "I_FOLDERDEPTH"));
+        if (folderDepth > 0 && depth < collapsedDepth && GetMediaTrackInfo_Value(track, "I_FOLDERCOMPACT") >= 2.0) {
+            collapsedDepth = depth;
+        }
+        depth += folderDepth;
+        if (depth <= collapsedDepth) {
+            collapsedDepth = INT_MAX; // left the collapsed folder
+        }
+    }
+}
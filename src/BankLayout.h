@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+
+// Tracks the mixer banks are made of: the master track and every track passing the bank filters (ini settings
+// bank_skip_hidden, bank_skip_collapsed, bank_max_depth). Banks, slots and track navigation work on positions in
+// this list, so hidden tracks take no slot and are skipped in one step. Built in a single pass over the project the
+// first time it is used after invalidate() (track list changed) or after the filter settings changed; every lookup
+// is O(1) after that.
+class BankLayout {
+public:
+    // Number of positions, position 0 is the master track
+    int size();
+    // Track number at position pos, -1 if there is none
+    int trackAt(int pos);
+    // Position of track number id, -1 if the track is filtered out
+    int positionOf(int id);
+    // Position of track number id or, if it is filtered out, of the next track after it that isn't (size() if none)
+    int rankOf(int id);
+    void invalidate() { dirty = true; }
+    // Whether the filter settings differ from the ones the layout was built with (config file reloaded)
+    bool filterChanged() const { return currentFilter() != filter; }
+    // Number of rebuilds since construction, for diagnostics
+    unsigned int rebuildCount() const { return rebuilds; }
+
+private:
+    struct Filter {
+        bool skipHidden = false;
+        bool skipCollapsed = false;
+        int maxDepth = -1;
+        bool operator!=(const Filter& other) const {
+            return skipHidden != other.skipHidden || skipCollapsed != other.skipCollapsed || maxDepth != other.maxDepth;
+        }
+    };
+
+    static Filter currentFilter();
+    void update();
+
+    std::vector<int> ids; // position -> track number
+    std::vector<int> ranks; // track number -> rankOf()
+    Filter filter;
+    bool dirty = true;
+    unsigned int rebuilds = 0;
+};
@@ -2,11 +2,6 @@
 #include <reaper/reaper_plugin_functions.h>
 #include <sstream>
 
-CommandHandlerTable& CommandHandlerTable::get() {
-    static CommandHandlerTable instance;
-    return instance;
-}
-
 void CommandHandlerTable::registerHandler(unsigned char command, HandlerFunc handler) {
     commandHandlers[command] = std::move(handler);
 }
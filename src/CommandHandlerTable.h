@@ -5,10 +5,9 @@
 
 using HandlerFunc = std::function<bool(unsigned char command, unsigned char value, const char* info)>;
 
+// Handlers by command. Every CommandProcessor owns its table, so handlers always act on their own surface.
 class CommandHandlerTable {
 public:
-    static CommandHandlerTable& get();
-
     void registerHandler(unsigned char command, HandlerFunc handler);
     bool dispatch(unsigned char command, unsigned char value, const char* info);
 
@@ -3,8 +3,9 @@
 #include "Commands.h"
 #include "Constants.h"
 #include "reaKontrol.h"
-#include "CommandHandlerTable.h"
+#include "SurfaceContext.h"
 #include "ActionList.h"
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <functional>
@@ -12,8 +13,8 @@
 
 // ---- Init & Registration & Handle ----
 
-CommandProcessor::CommandProcessor(MidiSender& sender, BaseSurface* surface)
-    : midiSender(sender), surface(surface) {
+CommandProcessor::CommandProcessor(SurfaceContext& ctx, MidiSender& sender, BaseSurface* surface)
+    : ctx(ctx), midiSender(sender), surface(surface) {
 
     // Transport Command Handlers
     registerHandler(CMD_PLAY, &CommandProcessor::handlePlay);
@@ -61,7 +62,7 @@ CommandProcessor::CommandProcessor(MidiSender& sender, BaseSurface* surface)
 }
 
 void CommandProcessor::Handle(unsigned char command, unsigned char value, const char* info) {
-    if (CommandHandlerTable::get().dispatch(command, value, info)) {
+    if (handlers.dispatch(command, value, info)) {
         LogCommand(command, value, "handled");
     }
     else {
@@ -73,7 +74,7 @@ void CommandProcessor::Handle(unsigned char command, unsigned char value, const
 
 bool CommandProcessor::handlePlay(unsigned char command, unsigned char value, const char* info) {
     if (info == EVENT_CLICK_DOUBLE) {
-        MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+        MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
         return toggleTrackSolo(track);
     }
     else {
@@ -115,11 +116,11 @@ bool CommandProcessor::handleStop(unsigned char command, unsigned char value, co
 }
 
 bool CommandProcessor::handleRec(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON || info == EVENT_CLICK_DOUBLE) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON || info == EVENT_CLICK_DOUBLE) {
         Main_OnCommand(9, 0); // Toggle record arm for selected track
     }
     else {
-        MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+        MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
         if (!track) return false;
 
         // Retrieve the record arm status
@@ -140,12 +141,12 @@ bool CommandProcessor::handleRec(unsigned char command, unsigned char value, con
 }
 
 bool CommandProcessor::handleLoop(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
         Main_OnCommand(40020, 0); // Time selection: Remove (unselect) time selection and loop points
-        setExtEditMode(EXT_EDIT_LOOP);
+        ctx.setExtEditMode(EXT_EDIT_LOOP);
     }
-    else if (getExtEditMode() == EXT_EDIT_LOOP) {
-        setExtEditMode(EXT_EDIT_OFF);
+    else if (ctx.getExtEditMode() == EXT_EDIT_LOOP) {
+        ctx.setExtEditMode(EXT_EDIT_OFF);
     }
     else {
         if (info == EVENT_CLICK_DOUBLE) {
@@ -179,20 +180,38 @@ bool CommandProcessor::handleRedo(unsigned char command, unsigned char value, co
 }
 
 bool CommandProcessor::handleQuantize(unsigned char command, unsigned char value, const char* info) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
+        ctx.setExtEditMode(EXT_EDIT_SENDS); // sends / receives of the focused track on the knobs
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SENDS) {
+        ctx.setExtEditMode(EXT_EDIT_OFF);
+        return true;
+    }
     Main_OnCommand(42033, 0);
     return true;
 }
 
 bool CommandProcessor::handleAuto(unsigned char command, unsigned char value, const char* info) {
-    if (g_trackInFocus < 1) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
+        ctx.setExtEditMode(EXT_EDIT_FX); // FX parameters of the focused track on the volume knobs
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_FX) {
+        ctx.setExtEditMode(EXT_EDIT_OFF);
+        return true;
+    }
+    if (ctx.state.trackInFocus < 1) {
         int mode = GetGlobalAutomationOverride();
         mode = (mode > 1) ? -1 : 4;
         SetGlobalAutomationOverride(mode);
     }
     else {
-        MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+        MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
         if (!track) return false;
-        int mode = *(int*)GetSetMediaTrackInfo(track, "I_AUTOMODE", nullptr);
+        int* autoMode = (int*)GetSetMediaTrackInfo(track, "I_AUTOMODE", nullptr);
+        if (!autoMode) return false;
+        int mode = *autoMode;
         mode = (mode > 1) ? 0 : 4;
         GetSetMediaTrackInfo(track, "I_AUTOMODE", &mode);
     }
@@ -200,12 +219,16 @@ bool CommandProcessor::handleAuto(unsigned char command, unsigned char value, co
 }
 
 bool CommandProcessor::toggleExtendedMode(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON) {
-        allMixerUpdate(&midiSender);
-        setExtEditMode(EXT_EDIT_OFF);
+    if (ctx.mixerHidden()) {
+        ctx.setExtEditMode(EXT_EDIT_OFF); // the surface redraws the mixer when leaving FX or routing mode
+    } else if (ctx.getExtEditMode() == EXT_EDIT_ON) {
+        allMixerUpdate(ctx, &midiSender);
+        ctx.setExtEditMode(EXT_EDIT_OFF);
     } else {
-        setExtEditMode(EXT_EDIT_ON);
-        showActionList(&midiSender);
+        ctx.setExtEditMode(EXT_EDIT_ON);
+        // The list may have fewer pages since the ini file was edited
+        ctx.actionPage = std::max(0, std::min(ctx.actionPage, g_actionList.pageCount() - 1));
+        showActionList(&midiSender, ctx.actionPage);
     }
     return true;
 }
@@ -216,14 +239,28 @@ bool CommandProcessor::handleMixerKnob(unsigned char command, unsigned char valu
     signed char delta = convertSignedMidiValue(value);
     MediaTrack* track = nullptr;
 
+    if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) return true; // slots show search results
+
+    if (ctx.getExtEditMode() == EXT_EDIT_FX) {
+        if (command >= CMD_KNOB_VOLUME0 && command <= CMD_KNOB_VOLUME7) {
+            bool adjusted = adjustFxParam(ctx, command - CMD_KNOB_VOLUME0, delta);
+            fxParamUpdate(ctx, &midiSender); // show the new value right away
+            return adjusted;
+        }
+        return true; // pan knobs have no function in FX mode
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SENDS) {
+        bool pan = (command >= CMD_KNOB_PAN0 && command <= CMD_KNOB_PAN7);
+        bool adjusted = adjustRoute(ctx, command - (pan ? CMD_KNOB_PAN0 : CMD_KNOB_VOLUME0), delta, pan);
+        routePageUpdate(ctx, &midiSender);
+        return adjusted;
+    }
     if (command >= CMD_KNOB_VOLUME0 && command <= CMD_KNOB_VOLUME7) {
-        int trackIndex = command - CMD_KNOB_VOLUME0;
-        track = CSurf_TrackFromID(trackIndex, false);
+        track = TrackFromSlot(command - CMD_KNOB_VOLUME0);
         return adjustTrackVolume(track, delta);
     }
     else if (command >= CMD_KNOB_PAN0 && command <= CMD_KNOB_PAN7) {
-        int trackIndex = command - CMD_KNOB_PAN0;
-        track = CSurf_TrackFromID(trackIndex, false);
+        track = TrackFromSlot(command - CMD_KNOB_PAN0);
         return adjustTrackPan(track, delta);
     }
     return false;
@@ -232,7 +269,12 @@ bool CommandProcessor::handleMixerKnob(unsigned char command, unsigned char valu
 // ---- Track Control Handlers ----
 
 bool CommandProcessor::handleTrackSelected(unsigned char command, unsigned char value, const char* info) {
-    MediaTrack* track = CSurf_TrackFromID(value, false);
+    if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        if (value >= BANK_NUM_TRACKS) return false;
+        return jumpToSearchResult(ctx.searchPage * BANK_NUM_TRACKS + value);
+    }
+    if (ctx.mixerHidden()) return true; // slots show parameters or routes, not tracks
+    MediaTrack* track = TrackFromSlot(value);
     if (!track) return false;
 
     int sel = 0;
@@ -245,23 +287,30 @@ bool CommandProcessor::handleTrackSelected(unsigned char command, unsigned char
 }
 
 bool CommandProcessor::handleTrackMuted(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_OFF) {
-        MediaTrack* track = CSurf_TrackFromID(value, false);
+    if (ctx.getExtEditMode() == EXT_EDIT_FX || ctx.getExtEditMode() == EXT_EDIT_SEARCH) return true;
+    if (ctx.getExtEditMode() == EXT_EDIT_SENDS) {
+        bool toggled = toggleRouteMute(ctx, value);
+        routePageUpdate(ctx, &midiSender);
+        return toggled;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_OFF) {
+        MediaTrack* track = TrackFromSlot(value);
         return toggleTrackMute(track);
     }
     else {
-        callAction(value, &midiSender);
+        callAction(ctx, value, &midiSender);
         return true;
     }
 }
 
 bool CommandProcessor::handleTrackSoloed(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_OFF) {
-        MediaTrack* track = CSurf_TrackFromID(value, false);
+    if (ctx.mixerHidden()) return true;
+    if (ctx.getExtEditMode() == EXT_EDIT_OFF) {
+        MediaTrack* track = TrackFromSlot(value);
         return toggleTrackSolo(track);
     }
     else {
-        callAction(value, &midiSender);
+        callAction(ctx, value, &midiSender);
         return true;
     }
 }
@@ -269,7 +318,7 @@ bool CommandProcessor::handleTrackSoloed(unsigned char command, unsigned char va
 // ---- Navigation Handlers ----
 
 bool CommandProcessor::handleNavTracks(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_LOOP) {
+    if (ctx.getExtEditMode() == EXT_EDIT_LOOP) {
         if (value == 127) {
             Main_OnCommand(40222, 0); // Loop points: Set start point
         }
@@ -278,14 +327,34 @@ bool CommandProcessor::handleNavTracks(unsigned char command, unsigned char valu
         }
         return true;
     }
+    else if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        // Right: append the first character that still has matches, left: remove the last character
+        if (convertSignedMidiValue(value) > 0) {
+            std::string chars = ctx.trackSearch.nextChars(ctx.searchQuery);
+            if (chars.empty() || ctx.searchQuery.size() >= TRACK_NAME_MAX_CHARS) return true;
+            ctx.searchQuery.push_back(chars.front());
+        }
+        else {
+            if (ctx.searchQuery.empty()) return true;
+            ctx.searchQuery.pop_back();
+        }
+        ctx.searchPage = 0;
+        searchPageUpdate(ctx, &midiSender);
+        return true;
+    }
     else {
+        // Steps along the bank layout, tracks filtered out of it are skipped. From a focused track that is filtered
+        // out itself, the next track is the first one after it in the layout.
         int step = convertSignedMidiValue(value);
-        int newFocus = g_trackInFocus + step;
+        int rank = ctx.bank.rankOf(ctx.state.trackInFocus);
+        bool inLayout = ctx.bank.trackAt(rank) == ctx.state.trackInFocus;
+        int pos = (inLayout || step < 0) ? rank + step : rank + step - 1;
         int numTracks = CSurf_NumTracks(false);
 
-        if (newFocus < 1 || newFocus > numTracks) newFocus = 1;
+        if (pos < 1 || pos >= ctx.bank.size()) pos = 1;
 
-        MediaTrack* track = CSurf_TrackFromID(newFocus, false);
+        int newFocus = ctx.bank.trackAt(pos);
+        MediaTrack* track = (newFocus > 0) ? CSurf_TrackFromID(newFocus, false) : nullptr;
         if (!track) return false;
 
         int sel = 0;
@@ -294,20 +363,44 @@ bool CommandProcessor::handleNavTracks(unsigned char command, unsigned char valu
 
         sel = 1;
         GetSetMediaTrackInfo(track, "I_SELECTED", &sel);
-        g_trackInFocus = newFocus;
+        ctx.state.trackInFocus = newFocus;
         return true;
     }
 }
 
 bool CommandProcessor::handleNavBanks(unsigned char command, unsigned char value, const char* info) {
     int step = convertSignedMidiValue(value);
-    int numTracks = CSurf_NumTracks(false);
-    int newBankStart = g_trackInFocus + step * BANK_NUM_TRACKS;
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
+        // Page through the action list
+        int page = std::max(0, std::min(ctx.actionPage + step, g_actionList.pageCount() - 1));
+        if (page != ctx.actionPage) {
+            ctx.actionPage = page;
+            showActionList(&midiSender, ctx.actionPage);
+        }
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_FX) {
+        // Page through the FX parameters, fxParamUpdate() keeps the page within range
+        ctx.fxPage += step;
+        fxParamUpdate(ctx, &midiSender);
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SENDS) {
+        ctx.routePage += step; // kept within range by routePageUpdate()
+        routePageUpdate(ctx, &midiSender);
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        ctx.searchPage += step; // kept within range by searchPageUpdate()
+        searchPageUpdate(ctx, &midiSender);
+        return true;
+    }
+    int pos = ctx.bank.rankOf(ctx.state.trackInFocus) + step * BANK_NUM_TRACKS;
 
-    if (newBankStart < 1 || newBankStart > numTracks) return false;
+    if (pos < 1 || pos >= ctx.bank.size()) return false;
 
-    g_trackInFocus = newBankStart;
-    MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+    ctx.state.trackInFocus = ctx.bank.trackAt(pos);
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
     if (!track) return false;
 
     int sel = 1;
@@ -317,20 +410,60 @@ bool CommandProcessor::handleNavBanks(unsigned char command, unsigned char value
 
 bool CommandProcessor::handleNavClips(unsigned char command, unsigned char value, const char* info) {
     int step = convertSignedMidiValue(value);
-    Main_OnCommand(step > 0 ? 40173 : 40172, 0);
+    if (ctx.getExtEditMode() == EXT_EDIT_FX) {
+        // Previous / next FX of the focused track
+        ctx.fxIndex = std::max(0, ctx.fxIndex + step);
+        ctx.fxPage = 0;
+        fxParamUpdate(ctx, &midiSender);
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SENDS) {
+        // Switch between the sends and the receives of the focused track
+        ctx.routeCategory = (step > 0) ? ROUTE_RECEIVES : ROUTE_SENDS;
+        ctx.routePage = 0;
+        routePageUpdate(ctx, &midiSender);
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        stepSearchChar(step);
+        return true;
+    }
+    double time = navigationTime();
+    if (ctx.getExtEditMode() == EXT_EDIT_ON && ctx.state.trackInFocus > 0) {
+        // Previous / next item of the focused track, before the first / past the last one the markers take over
+        MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
+        const ItemEntry* item = !track ? nullptr : (step > 0) ? ctx.items.next(track, time) : ctx.items.previous(track, time);
+        if (item) {
+            SetEditCurPos(item->position, true, true);
+            return true;
+        }
+    }
+    // Previous / next marker or region start
+    const MarkerEntry* marker = (step > 0) ? ctx.markers.next(time) : ctx.markers.previous(time);
+    if (!marker) {
+        Main_OnCommand(step > 0 ? 40173 : 40172, 0); // Markers: Go to next marker/project end, previous marker/project start
+        return true;
+    }
+    SetEditCurPos(marker->position, true, true);
+    if (ctx.getExtEditMode() == EXT_EDIT_OFF) {
+        showPositionInMixer(ctx, &midiSender, 0, marker->name, marker->position);
+    }
     return true;
 }
 
 bool CommandProcessor::handlePlayClip(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
         Main_OnCommand(40012, 0); // Item: Split items at edit or play cursor (select right)
         return true;
     }
-    else if (getExtEditMode() == EXT_EDIT_OFF) {
-        bool tryTargetFirstTrack = g_trackInFocus == 0;
-        MediaTrack* track = CSurf_TrackFromID(tryTargetFirstTrack ? 1 : g_trackInFocus, false);
+    else if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        return jumpToSearchResult(ctx.searchPage * BANK_NUM_TRACKS); // first match on the page
+    }
+    else if (ctx.getExtEditMode() == EXT_EDIT_OFF) {
+        bool tryTargetFirstTrack = ctx.state.trackInFocus == 0;
+        MediaTrack* track = CSurf_TrackFromID(tryTargetFirstTrack ? 1 : ctx.state.trackInFocus, false);
         if (!track) return false;
-        g_trackInFocus = tryTargetFirstTrack ? 1 : g_trackInFocus;
+        ctx.state.trackInFocus = tryTargetFirstTrack ? 1 : ctx.state.trackInFocus;
         
         if (info == EVENT_CLICK_DOUBLE) {
             // Toggle fxWindow
@@ -360,7 +493,7 @@ bool CommandProcessor::handleLoopMove(unsigned char command, unsigned char value
 // ---- Selected Track Knob Handlers ----
 
 bool CommandProcessor::handleSelectedTrackVolume(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON || getExtEditMode() == EXT_EDIT_LOOP) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON || ctx.getExtEditMode() == EXT_EDIT_LOOP) {
         // Scroll playhead to next/previous grid division
         if (value <= 63) {
             Main_OnCommand(40647, 0); // move cursor right 1 grid division (no seek)
@@ -370,9 +503,13 @@ bool CommandProcessor::handleSelectedTrackVolume(unsigned char command, unsigned
         }
         return true;
     }
+    else if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        stepSearchChar(convertSignedMidiValue(value));
+        return true;
+    }
     else {
         // Adjust selected track vol (default 0 master track)
-        MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+        MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
         signed char vol = convertSignedMidiValue(value);
         if (command == CMD_MOVE_TRANSPORT) {
             // The signal is 1 : 127 => 1 : -1, which is too small for volume. So we make it the same value as the track volume cmd
@@ -383,30 +520,41 @@ bool CommandProcessor::handleSelectedTrackVolume(unsigned char command, unsigned
 }
 
 bool CommandProcessor::handleSelectedTrackPan(unsigned char command, unsigned char value, const char* info) {
-    if (g_trackInFocus < 1) return false;
-    MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+    if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) return true;
+    if (ctx.state.trackInFocus < 1) return false;
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
     return adjustTrackPan(track, convertSignedMidiValue(value));
 }
 
 bool CommandProcessor::handleSelectedTrackMute(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON) { return true; }
-    if (g_trackInFocus < 1) return false;
-    MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
+        // Jump to track: spell a name with the 4D encoder, pick a match with a slot button
+        ctx.searchQuery.clear();
+        ctx.searchPage = 0;
+        ctx.setExtEditMode(EXT_EDIT_SEARCH);
+        return true;
+    }
+    if (ctx.getExtEditMode() == EXT_EDIT_SEARCH) {
+        ctx.setExtEditMode(EXT_EDIT_OFF);
+        return true;
+    }
+    if (ctx.state.trackInFocus < 1) return false;
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
     return toggleTrackMute(track);
 }
 
 bool CommandProcessor::handleSelectedTrackSolo(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON) { return true; }
+    if (ctx.getExtEditMode() == EXT_EDIT_ON || ctx.getExtEditMode() == EXT_EDIT_SEARCH) { return true; }
 
-    if (g_trackInFocus < 1) return false;
-    MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+    if (ctx.state.trackInFocus < 1) return false;
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
     return toggleTrackSolo(track);
 }
 
 // ---- Miscellaneous Handlers ----
 
 bool CommandProcessor::handleClear(unsigned char command, unsigned char value, const char* info) {
-    if (getExtEditMode() == EXT_EDIT_ON) {
+    if (ctx.getExtEditMode() == EXT_EDIT_ON) {
         Main_OnCommand(40005, 0); // Remove selected track
         if (surface) {
             surface->SetTrackListChange();
@@ -421,10 +569,12 @@ bool CommandProcessor::handleClear(unsigned char command, unsigned char value, c
 }
 
 bool CommandProcessor::handleCount(unsigned char command, unsigned char value, const char* info) {
-    g_KKcountInTriggered = true;
-    g_KKcountInMetroState = (*(int*)GetConfigVar("projmetroen") & 1);
+    int* metronome = getProjMetroEn();
+    if (!metronome) return false;
+    ctx.countInTriggered = true;
+    ctx.countInMetroState = (*metronome & 1);
     Main_OnCommand(41745, 0);        // Enable metronome
-    *(int*)GetConfigVar("projmetroen") |= 16; // Enable count-in
+    *metronome |= 16; // Enable count-in
     CSurf_OnRecord();
     return true;
 }
@@ -434,28 +584,45 @@ bool CommandProcessor::handleCount(unsigned char command, unsigned char value, c
 
 template <typename Method>
 void CommandProcessor::registerHandler(unsigned char cmd, Method method) {
-    CommandHandlerTable::get().registerHandler(cmd, std::bind(method, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    handlers.registerHandler(cmd, std::bind(method, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
 }
 
 void CommandProcessor::RefocusBank()
 {
     // Switch Mixer view to the bank containing the currently focused (= selected) track and also focus Reaper's TCP and MCP
-    if (g_trackInFocus < 1) {
+    if (ctx.state.trackInFocus < 1) {
         return;
     }
     int numTracks = CSurf_NumTracks(false);
     // Backstop measure to protect against unreported track removal that was not captured in SetTrackListChange callback due to race condition
-    if (g_trackInFocus > numTracks) {
-        g_trackInFocus = numTracks;
+    if (ctx.state.trackInFocus > numTracks) {
+        ctx.state.trackInFocus = numTracks;
+    }
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
+    if (!track) {
+        return;
     }
-    MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
     int iSel = 1; // "Select"
     ClearAllSelectedTracks();
     GetSetMediaTrackInfo(track, "I_SELECTED", &iSel);
     Main_OnCommand(40913, 0); // Vertical scroll selected track into view (TCP)
     SetMixerScroll(track); // Horizontal scroll making the selected track the leftmost track if possible (MCP)
-    bankStart = (int)(g_trackInFocus / BANK_NUM_TRACKS) * BANK_NUM_TRACKS;
-    allMixerUpdate(&midiSender);
+    int pos = std::min(ctx.bank.rankOf(ctx.state.trackInFocus), ctx.bank.size() - 1);
+    ctx.state.bankStart = (int)(pos / BANK_NUM_TRACKS) * BANK_NUM_TRACKS;
+    allMixerUpdate(ctx, &midiSender);
+}
+
+MediaTrack* CommandProcessor::TrackFromSlot(int slot) {
+    // Slot buttons and knobs address the 8 tracks of the current bank. The slot is sent by the keyboard and is not
+    // trusted: anything outside the bank or beyond the last track yields nullptr.
+    if (slot < 0 || slot >= BANK_NUM_TRACKS) {
+        return nullptr;
+    }
+    int id = ctx.bank.trackAt(ctx.state.bankStart + slot);
+    if (id < 0 || id > CSurf_NumTracks(false)) {
+        return nullptr;
+    }
+    return CSurf_TrackFromID(id, false);
 }
 
 void CommandProcessor::ClearAllSelectedTracks() {
@@ -465,6 +632,40 @@ void CommandProcessor::ClearAllSelectedTracks() {
         GetSetMediaTrackInfo(CSurf_TrackFromID(i, false), "I_SELECTED", &iSel);
 }
 
+void CommandProcessor::stepSearchChar(int step) {
+    // Turns the last character of the query through the characters that still give matches. An empty query starts
+    // with the first (turning right) or last (turning left) character any word starts with.
+    if (step == 0) return;
+    std::string base = ctx.searchQuery;
+    char current = 0;
+    if (!base.empty()) {
+        current = base.back();
+        base.pop_back();
+    }
+    std::string chars = ctx.trackSearch.nextChars(base);
+    if (chars.empty()) return;
+    int count = static_cast<int>(chars.size());
+    size_t found = ctx.searchQuery.empty() ? std::string::npos : chars.find(current);
+    int index = 0;
+    if (found == std::string::npos) {
+        index = (step > 0) ? 0 : count - 1;
+    }
+    else {
+        index = ((static_cast<int>(found) + step) % count + count) % count;
+    }
+    ctx.searchQuery = base + chars[index];
+    ctx.searchPage = 0;
+    searchPageUpdate(ctx, &midiSender);
+}
+
+bool CommandProcessor::jumpToSearchResult(int index) {
+    if (index < 0 || index >= static_cast<int>(ctx.searchResults.size())) return false;
+    ctx.state.trackInFocus = ctx.searchResults[index];
+    ctx.setExtEditMode(EXT_EDIT_OFF); // the surface redraws the mixer
+    RefocusBank();
+    return true;
+}
+
 void CommandProcessor::LogCommand(unsigned char command, unsigned char value, const std::string& context)
 {
     std::ostringstream msg;
@@ -1,24 +1,36 @@
 #pragma once
 
 #include "MidiSender.h"
+#include "CommandHandlerTable.h"
 class BaseSurface;
+class MediaTrack;
+struct SurfaceContext;
 
 class CommandProcessor {
 public:
-    CommandProcessor(MidiSender& sender, BaseSurface* surface = nullptr);
+    CommandProcessor(SurfaceContext& ctx, MidiSender& sender, BaseSurface* surface = nullptr);
+    // The registered handlers are bound to this instance
+    CommandProcessor(const CommandProcessor&) = delete;
+    CommandProcessor& operator=(const CommandProcessor&) = delete;
 
     // Main entry point to handle MIDI CC events
     void Handle(unsigned char command, unsigned char value, const char* info);
 
 private:
+    SurfaceContext& ctx;
     MidiSender& midiSender;
     BaseSurface* surface;
+    CommandHandlerTable handlers;
 
     template <typename Method>
     void registerHandler(unsigned char cmd, Method method);
     
     void RefocusBank();
+    MediaTrack* TrackFromSlot(int slot);
     void ClearAllSelectedTracks();
+    // Jump to track mode
+    void stepSearchChar(int step);
+    bool jumpToSearchResult(int index);
     void LogCommand(unsigned char command, unsigned char value, const std::string& context);
 
     // Handler methods
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 class MediaTrack;
 
 // Compile-time constants
 constexpr int BANK_NUM_TRACKS = 8;
+constexpr size_t TRACK_NAME_MAX_CHARS = 32; // longer names don't fit a display slot
 constexpr unsigned char TRTYPE_UNSPEC = 1;
 constexpr unsigned char TRTYPE_MIDI = 2;
 constexpr unsigned char TRTYPE_AUDIO = 3;
@@ -11,51 +15,52 @@ constexpr unsigned char TRTYPE_GROUP = 4;
 constexpr unsigned char TRTYPE_BUS = 5;
 constexpr unsigned char TRTYPE_MASTER = 6;
 
-constexpr int DOUBLE_CLICK_THRESHOLD = 20;
-constexpr int CLICK_COOLDOWN = 20;
+// Timings in ms on the monotonic clock (see TimerWheel.h). The values match the former frame counts at REAPER's
+// default control surface rate of about 30 Run() calls per second.
+constexpr int DOUBLE_CLICK_MS = 650; // second click must arrive within this time
+constexpr int CLICK_COOLDOWN_MS = 650; // no new click gesture is accepted for this time after a click was handled
+constexpr int POSITION_TEXT_MS = 2000; // name and position of a marker / item jumped to replace a slot's volume / pan text
 constexpr const char* EVENT_CLICK_SINGLE = "SINGLE";
 constexpr const char* EVENT_CLICK_DOUBLE = "DOUBLE";
 
 constexpr bool HIDE_MUTED_BY_SOLO = false;
 
-constexpr int FLASH_T = 16;
-constexpr int CYCLE_T = 6;
-constexpr int SCAN_T = 90;
+constexpr int FLASH_MS = 500; // button flashing in extended edit modes
+constexpr int CYCLE_MS = 200; // encoder LED cycling in extended edit modes
+constexpr int ACTION_TOGGLE_MS = 250; // toggle state polling of the shown action page
+constexpr double FX_KNOB_STEP = 0.001; // normalized change of a continuous FX parameter per knob increment
+constexpr int SCAN_MS = 3000; // MIDI device scan and NIHIA handshake retries
+constexpr int SCAN_MAX_MS = 60000; // scan retries back off exponentially up to this interval
 constexpr int CONNECT_N = 2;
+constexpr int LIVENESS_MS = 2000; // check that the connected keyboard is still plugged in
+constexpr int SELECTION_DEBOUNCE_MS = 100; // default for g_selectionDebounceMs
 
 constexpr int EXT_EDIT_OFF = 0; // no Extended Edit, Normal Mode. flashTimer = -1 
 constexpr int EXT_EDIT_ON = 1; // Extended Edit 1st stage commands
 constexpr int EXT_EDIT_LOOP = 2; // Extended: Set Loop Range
 constexpr int EXT_EDIT_TEMPO = 3; // Extended Edit TEMPO
+constexpr int EXT_EDIT_FX = 4; // Extended: FX parameters on the 8 volume knobs
+constexpr int EXT_EDIT_SENDS = 5; // Extended: sends / receives of the focused track on the knobs
+constexpr int EXT_EDIT_SEARCH = 6; // Extended: jump to a track found by name
 
 constexpr int KK_NOT_CONNECTED = 0; // not connected / scanning
 constexpr int KK_MIDI_FOUND = 1; // KK MIDI device found / trying to connect to NIHIA
 constexpr int KK_NIHIA_CONNECTED = 2; // NIHIA HELLO acknowledged / fully connected
 
+#define CSURF_EXT_RESET 0x0001FFFF
 #define CSURF_EXT_SETMETRONOME 0x00010002
+#define CSURF_EXT_SETSENDVOLUME 0x00010005
+#define CSURF_EXT_SETSENDPAN 0x00010006
+#define CSURF_EXT_SETRECVVOLUME 0x00010010
+#define CSURF_EXT_SETRECVPAN 0x00010011
+#define CSURF_EXT_SETPROJECTMARKERCHANGE 0x00010014
 
-// Global variables
+// Global variables, shared by all surfaces. Per keyboard state lives in SurfaceContext.
 extern bool g_debugLogging;
-extern int nextOpenTimer; // Cooldown time for processing next click events
-
-extern int protocolVersion;
-extern int bankStart;
-extern int bankEnd;
-extern int scanTimer;
-extern int connectCount;
-
-extern int g_trackInFocus;
-extern bool g_anySolo;
-extern int g_soloStateBank[BANK_NUM_TRACKS];
-extern bool g_muteStateBank[BANK_NUM_TRACKS];
-
-extern bool g_KKcountInTriggered;
-extern int g_KKcountInMetroState;
-
-int getExtEditMode();
-void setExtEditMode(int newMode);
-
-extern int g_connectedState;
+extern int g_selectionDebounceMs; // master track fallback waits this long for the selection to settle (ini: selection_debounce_ms)
+extern bool g_bankSkipHidden; // banks leave out tracks hidden in the mixer (ini: bank_skip_hidden)
+extern bool g_bankSkipCollapsed; // banks leave out children of collapsed folders (ini: bank_skip_collapsed)
+extern int g_bankMaxDepth; // banks leave out tracks nested deeper, -1: no limit (ini: bank_max_depth)
 
 #ifdef CONNECTION_DIAGNOSTICS
 extern int log_scanAttempts;
@@ -68,6 +73,9 @@ inline const char* getConstantName(unsigned char cons) {
     case EXT_EDIT_ON: return "EXT_EDIT_ON";
     case EXT_EDIT_LOOP: return "EXT_EDIT_LOOP";
     case EXT_EDIT_TEMPO: return "EXT_EDIT_TEMPO";
+    case EXT_EDIT_FX: return "EXT_EDIT_FX";
+    case EXT_EDIT_SENDS: return "EXT_EDIT_SENDS";
+    case EXT_EDIT_SEARCH: return "EXT_EDIT_SEARCH";
     default: return "UNKNOWN";
     }
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include "FxParamCache.h"
+#include "TrackNameCache.h"
+#include "Constants.h"
+#include "reaKontrol.h"
+
+namespace {
+    // Entries of removed FX are never looked up again, start over once this many piled up
+    constexpr size_t MAX_ENTRIES = 1024;
+}
+
+FxParamCache::Fx* FxParamCache::find(MediaTrack* track, int fx) {
+    if (!track || fx < 0) return nullptr;
+    const GUID* guid = TrackFX_GetFXGUID(track, fx);
+    if (!guid) return nullptr;
+    GuidKey key = makeGuidKey(guid);
+
+    if (entries.size() >= MAX_ENTRIES && entries.find(key) == entries.end()) {
+        clear();
+    }
+    Fx& entry = entries[key];
+    // Plugins may change their parameter count (e.g. after loading a preset), metadata of the others stays
+    int numParams = TrackFX_GetNumParams(track, fx);
+    if (numParams < 0) numParams = 0;
+    if (static_cast<int>(entry.params.size()) != numParams) {
+        entry.params.resize(numParams);
+    }
+    return &entry;
+}
+
+const FxParamInfo& FxParamCache::param(MediaTrack* track, int fx, Fx& entry, int index) {
+    FxParamInfo& info = entry.params[index];
+    if (info.loaded) return info;
+
+    char buf[256] = { 0 };
+    if (!TrackFX_GetParamName(track, fx, index, buf, sizeof(buf)) || buf[0] == '\0') {
+        snprintf(buf, sizeof(buf), "Param %d", index + 1);
+    }
+    info.name = toDisplayName(buf, TRACK_NAME_MAX_CHARS);
+
+    double step = 0.0, smallStep = 0.0, largeStep = 0.0;
+    bool isToggle = false;
+    if (TrackFX_GetParameterStepSizes(track, fx, index, &step, &smallStep, &largeStep, &isToggle)) {
+        double minValue = 0.0, maxValue = 1.0;
+        TrackFX_GetParam(track, fx, index, &minValue, &maxValue);
+        info.isToggle = isToggle;
+        info.step = (step > 0.0 && maxValue > minValue) ? step / (maxValue - minValue) : 0.0;
+    }
+    info.loaded = true;
+    ++reads;
+    return info;
+}
+
+void FxParamCache::clear() {
+    entries.clear();
+    ++generations;
+}
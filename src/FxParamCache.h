@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GuidKey.h"
+
+class MediaTrack;
+
+// Metadata of one FX parameter, read from REAPER the first time the parameter is on the display
+struct FxParamInfo {
+    bool loaded = false;
+    std::string name; // display form, see toDisplayName()
+    double step = 0.0; // normalized step of stepped parameters, 0: continuous
+    bool isToggle = false;
+};
+
+// What FX parameter mode last put on one display slot
+struct FxSlotCache {
+    int param = -1; // -1: slot empty
+    double value = -1.0; // normalized value, -1: not sent yet
+    int knob = -1;
+};
+
+// Parameter metadata per FX, keyed by the FX GUID, so entries stay valid when the FX chain is reordered or the focus
+// moves between tracks. Only parameters that are shown get read: paging through a synth with hundreds of parameters
+// costs 8 metadata reads per new page and nothing for pages seen before.
+class FxParamCache {
+public:
+    struct Fx {
+        std::vector<FxParamInfo> params;
+    };
+
+    // Entry of FX fx on track with one (possibly not yet loaded) FxParamInfo per parameter, nullptr if there is no such FX
+    Fx* find(MediaTrack* track, int fx);
+    const FxParamInfo& param(MediaTrack* track, int fx, Fx& entry, int index);
+    void clear();
+    // Changes whenever entries were dropped, so Fx pointers from before must not be compared with new ones
+    unsigned int generation() const { return generations; }
+    // Number of parameters whose metadata was read since construction, for diagnostics
+    unsigned int readCount() const { return reads; }
+
+private:
+    std::unordered_map<GuidKey, Fx, GuidKeyHash> entries;
+    unsigned int generations = 0;
+    unsigned int reads = 0;
+};
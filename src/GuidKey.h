@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// A REAPER GUID (track, FX) as hash map key: entries stay valid when tracks or FX are inserted, removed or moved
+struct GuidKey {
+    uint64_t lo;
+    uint64_t hi;
+    bool operator==(const GuidKey& other) const { return lo == other.lo && hi == other.hi; }
+};
+
+struct GuidKeyHash {
+    size_t operator()(const GuidKey& key) const { return static_cast<size_t>(key.lo ^ (key.hi * 0x9E3779B97F4A7C15ull)); }
+};
+
+// Guid is REAPER's GUID, a template so this header doesn't need the platform headers
+template <typename Guid>
+GuidKey makeGuidKey(const Guid* guid) {
+    GuidKey key;
+    key.lo = static_cast<uint64_t>(guid->Data1) | (static_cast<uint64_t>(guid->Data2) << 32) |
+        (static_cast<uint64_t>(guid->Data3) << 48);
+    memcpy(&key.hi, guid->Data4, sizeof(key.hi));
+    return key;
+}
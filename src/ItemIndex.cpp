@@ -0,0 +1,59 @@
+#include <algorithm>
+#include "ItemIndex.h"
+#include "reaKontrol.h"
+
+namespace {
+    // Positions closer than this count as the same, the cursor is set to exactly the start of an item anyway
+    constexpr double POSITION_EPSILON = 0.000001;
+
+    bool positionLess(const ItemEntry& entry, double time) { return entry.position < time; }
+    bool timeLess(double time, const ItemEntry& entry) { return time < entry.position; }
+}
+
+void ItemIndex::update(MediaTrack* track) {
+    if (!track) {
+        entries.clear();
+        indexed = nullptr;
+        return;
+    }
+    int state = GetProjectStateChangeCount(nullptr);
+    int numItems = CountTrackMediaItems(track);
+    if (track == indexed && readAt == changes && state == stateCount && numItems == count) return;
+
+    entries.clear();
+    entries.reserve(numItems);
+    for (int i = 0; i < numItems; ++i) {
+        MediaItem* item = GetTrackMediaItem(track, i);
+        if (!item) continue;
+        ItemEntry entry;
+        entry.position = GetMediaItemInfo_Value(item, "D_POSITION");
+        entries.push_back(entry);
+    }
+    // REAPER keeps a track's items in position order, the sort is only a pass over them then
+    if (!std::is_sorted(entries.begin(), entries.end(),
+        [](const ItemEntry& a, const ItemEntry& b) { return a.position < b.position; })) {
+        std::sort(entries.begin(), entries.end(), [](const ItemEntry& a, const ItemEntry& b) { return a.position < b.position; });
+    }
+    indexed = track;
+    readAt = changes;
+    stateCount = state;
+    count = numItems;
+    ++rebuilds;
+}
+
+const ItemEntry* ItemIndex::next(MediaTrack* track, double time) {
+    update(track);
+    auto it = std::upper_bound(entries.begin(), entries.end(), time + POSITION_EPSILON, timeLess);
+    return (it != entries.end()) ? &*it : nullptr;
+}
+
+const ItemEntry* ItemIndex::previous(MediaTrack* track, double time) {
+    update(track);
+    auto it = std::lower_bound(entries.begin(), entries.end(), time - POSITION_EPSILON, positionLess);
+    return (it != entries.begin()) ? &*(it - 1) : nullptr;
+}
+
+size_t ItemIndex::size(MediaTrack* track) {
+    update(track);
+    return entries.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+class MediaTrack;
+
+// One media item of a track
+struct ItemEntry {
+    double position = 0.0;
+};
+
+// Media items of one track (the focused one) sorted by position, for stepping through them from the cursor with a
+// binary search. Only positions are kept, names aren't needed for stepping. Read again when asked for another
+// track, after invalidate() (track list changed), when the project's state change count moved (every item edit is an
+// undo point, but so is any knob turn) or when the track's item count differs.
+class ItemIndex {
+public:
+    void invalidate() { ++changes; }
+    // First item of track after / before time, nullptr if there is none
+    const ItemEntry* next(MediaTrack* track, double time);
+    const ItemEntry* previous(MediaTrack* track, double time);
+    size_t size(MediaTrack* track);
+    // Number of times items were read since construction, for diagnostics
+    unsigned int rebuildCount() const { return rebuilds; }
+
+private:
+    void update(MediaTrack* track);
+
+    std::vector<ItemEntry> entries;
+    MediaTrack* indexed = nullptr;
+    unsigned int changes = 0;
+    unsigned int readAt = ~0u; // changes when the entries were read
+    int stateCount = -1; // GetProjectStateChangeCount() when the entries were read
+    int count = -1;
+    unsigned int rebuilds = 0;
+};
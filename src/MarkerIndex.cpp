@@ -0,0 +1,64 @@
+#include <algorithm>
+#include "MarkerIndex.h"
+#include "TrackNameCache.h"
+#include "Constants.h"
+#include "reaKontrol.h"
+
+namespace {
+    // Positions closer than this count as the same, the cursor is set to exactly the position of a marker anyway
+    constexpr double POSITION_EPSILON = 0.000001;
+
+    bool positionLess(const MarkerEntry& entry, double time) { return entry.position < time; }
+    bool timeLess(double time, const MarkerEntry& entry) { return time < entry.position; }
+}
+
+void MarkerIndex::update() {
+    int numMarkers = 0;
+    int numRegions = 0;
+    int total = CountProjectMarkers(nullptr, &numMarkers, &numRegions);
+    if (readAt == changes && total == count) return;
+
+    entries.clear();
+    entries.reserve(total);
+    bool isRegion = false;
+    double position = 0.0;
+    double regionEnd = 0.0;
+    const char* name = nullptr;
+    int number = 0;
+    for (int i = 0; EnumProjectMarkers3(nullptr, i, &isRegion, &position, &regionEnd, &name, &number, nullptr); ++i) {
+        MarkerEntry entry;
+        entry.position = position;
+        entry.number = number;
+        entry.isRegion = isRegion;
+        if (name && name[0]) {
+            entry.name = toDisplayName(name, TRACK_NAME_MAX_CHARS);
+        }
+        else {
+            entry.name = (isRegion ? "Region " : "Marker ") + std::to_string(number);
+        }
+        entries.push_back(std::move(entry));
+    }
+    // REAPER enumerates in position order already, but don't rely on it for the binary search
+    std::stable_sort(entries.begin(), entries.end(),
+        [](const MarkerEntry& a, const MarkerEntry& b) { return a.position < b.position; });
+    readAt = changes;
+    count = total;
+    ++rebuilds;
+}
+
+const MarkerEntry* MarkerIndex::next(double time) {
+    update();
+    auto it = std::upper_bound(entries.begin(), entries.end(), time + POSITION_EPSILON, timeLess);
+    return (it != entries.end()) ? &*it : nullptr;
+}
+
+const MarkerEntry* MarkerIndex::previous(double time) {
+    update();
+    auto it = std::lower_bound(entries.begin(), entries.end(), time - POSITION_EPSILON, positionLess);
+    return (it != entries.begin()) ? &*(it - 1) : nullptr;
+}
+
+size_t MarkerIndex::size() {
+    update();
+    return entries.size();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// One marker or region start of the project
+struct MarkerEntry {
+    double position = 0.0;
+    int number = 0; // the number REAPER shows
+    bool isRegion = false;
+    std::string name; // display form, see toDisplayName()
+};
+
+// Markers and region starts of the project sorted by position, for stepping through them from the cursor with a binary
+// search. Read again only after invalidate() (CSURF_EXT_SETPROJECTMARKERCHANGE or project switch) or when REAPER
+// reports a different number of markers and regions than were read.
+class MarkerIndex {
+public:
+    void invalidate() { ++changes; }
+    // First entry after / before time, nullptr if there is none
+    const MarkerEntry* next(double time);
+    const MarkerEntry* previous(double time);
+    size_t size();
+    // Number of times the markers were read since construction, for diagnostics
+    unsigned int rebuildCount() const { return rebuilds; }
+
+private:
+    void update();
+
+    std::vector<MarkerEntry> entries;
+    unsigned int changes = 0;
+    unsigned int readAt = ~0u; // changes when the entries were read
+    int count = -1; // markers and regions REAPER reported when the entries were read
+    unsigned int rebuilds = 0;
+};
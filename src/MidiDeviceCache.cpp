@@ -0,0 +1,135 @@
+#include <cctype>
+#include <cstring>
+#include "MidiDeviceCache.h"
+#include "reaKontrol.h"
+
+namespace {
+    constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    void hashBytes(uint64_t& hash, const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ p[i]) * FNV_PRIME;
+        }
+    }
+
+    const char* const KK_MODELS[] = { "KONTROL S49 MK3", "KONTROL S61 MK3", "KONTROL S88 MK3" };
+    const char* const KK_DAW_PORT = "DAW"; // macOS / Linux, same name for both directions
+    const char* const KK_DAW_INPUT = "MIDIIN2"; // Windows
+    const char* const KK_DAW_OUTPUT = "MIDIOUT2";
+
+    void eraseToken(std::string& name, const std::string& upper, const char* token) {
+        size_t pos = upper.find(token);
+        if (pos != std::string::npos) {
+            name.erase(pos, strlen(token));
+        }
+    }
+}
+
+bool matchKkPortName(const std::string& name, bool input, std::string& keyboard) {
+    std::string upper(name);
+    for (char& c : upper) {
+        c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+    bool model = false;
+    for (const char* m : KK_MODELS) {
+        if (upper.find(m) != std::string::npos) {
+            model = true;
+            break;
+        }
+    }
+    if (!model) {
+        return false;
+    }
+    const char* own = input ? KK_DAW_INPUT : KK_DAW_OUTPUT;
+    const char* other = input ? KK_DAW_OUTPUT : KK_DAW_INPUT;
+    keyboard = name;
+    if (upper.find(own) != std::string::npos) {
+        eraseToken(keyboard, upper, own);
+        return true;
+    }
+    // MIDIOUT2 on the input side is never a match, even though it doesn't contain MIDIIN2
+    if (upper.find(other) == std::string::npos && upper.find(KK_DAW_PORT) != std::string::npos) {
+        return true;
+    }
+    return false;
+}
+
+const std::vector<KkMidiDevices>& MidiDeviceCache::find() {
+    int numInputs = GetNumMIDIInputs();
+    int numOutputs = GetNumMIDIOutputs();
+    numInputs = (numInputs < 0) ? 0 : numInputs;
+    numOutputs = (numOutputs < 0) ? 0 : numOutputs;
+    inputNames.resize(numInputs);
+    outputNames.resize(numOutputs);
+
+    // Inputs and outputs in one pass, the keyboard's ports usually share an index
+    uint64_t hash = FNV_OFFSET;
+    hashBytes(hash, &numInputs, sizeof(numInputs));
+    hashBytes(hash, &numOutputs, sizeof(numOutputs));
+    int count = (numInputs > numOutputs) ? numInputs : numOutputs;
+    for (int dev = 0; dev < count; ++dev) {
+        if (dev < numInputs) {
+            readName(dev, true, inputNames[dev], hash);
+        }
+        if (dev < numOutputs) {
+            readName(dev, false, outputNames[dev], hash);
+        }
+    }
+    if (valid && hash == fingerprint) {
+        return keyboards;
+    }
+
+    fingerprint = hash;
+    valid = true;
+    ++matches;
+    match();
+    return keyboards;
+}
+
+bool MidiDeviceCache::isListed(const KkMidiDevices& devices) {
+    if (!devices.found() || devices.input >= GetNumMIDIInputs() || devices.output >= GetNumMIDIOutputs()) {
+        return false;
+    }
+    char name[128];
+    std::string keyboard;
+    if (!GetMIDIInputName(devices.input, name, sizeof(name))) return false;
+    name[sizeof(name) - 1] = '\0';
+    if (!matchKkPortName(name, true, keyboard) || keyboard != devices.keyboard) return false;
+    if (!GetMIDIOutputName(devices.output, name, sizeof(name))) return false;
+    name[sizeof(name) - 1] = '\0';
+    return matchKkPortName(name, false, keyboard) && keyboard == devices.keyboard;
+}
+
+void MidiDeviceCache::readName(int dev, bool input, std::string& nameOut, uint64_t& hash) {
+    char name[128];
+    bool present = input ? GetMIDIInputName(dev, name, sizeof(name)) : GetMIDIOutputName(dev, name, sizeof(name));
+    if (!present) {
+        name[0] = '\0';
+    }
+    name[sizeof(name) - 1] = '\0';
+    size_t len = strlen(name);
+    hashBytes(hash, name, len + 1); // with the terminator, so "ab"+"c" and "a"+"bc" differ
+    nameOut.assign(name, len);
+}
+
+void MidiDeviceCache::match() {
+    keyboards.clear();
+    std::string keyboard;
+    for (size_t in = 0; in < inputNames.size(); ++in) {
+        if (inputNames[in].empty() || !matchKkPortName(inputNames[in], true, keyboard)) continue;
+        // Pair with the output port of the same keyboard
+        std::string outKeyboard;
+        for (size_t out = 0; out < outputNames.size(); ++out) {
+            if (!outputNames[out].empty() && matchKkPortName(outputNames[out], false, outKeyboard) && outKeyboard == keyboard) {
+                KkMidiDevices devices;
+                devices.input = static_cast<int>(in);
+                devices.output = static_cast<int>(out);
+                devices.keyboard = keyboard;
+                keyboards.push_back(devices);
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// MIDI ports of one keyboard, -1 if not listed
+struct KkMidiDevices {
+    int input = -1;
+    int output = -1;
+    std::string keyboard; // port name without the direction, identifies the keyboard across rescans
+
+    bool found() const { return input != -1 && output != -1; }
+};
+
+// Returns true if name is the DAW port of a Komplete Kontrol S49/S61/S88 Mk3 in the given direction. Windows lists
+// them as "MIDIIN2 (KONTROL S61 MK3)" / "MIDIOUT2 (KONTROL S61 MK3)" (prefixed with "2- " etc. for further keyboards
+// of the same model), macOS and Linux as "KONTROL S61 MK3 DAW". keyboard receives the name without the direction.
+bool matchKkPortName(const std::string& name, bool input, std::string& keyboard);
+
+// Cached view of REAPER's MIDI device table. find() reads the device count and names once per call and only matches
+// them against the keyboard port names when the count or the fingerprint of the names changed since the last call,
+// so polling for keyboards (initial scan, hot-plug detection) stays cheap in studios with many MIDI ports.
+// REAPER keeps the index of an unplugged device and only stops reporting its name, so presence is part of the
+// fingerprint.
+class MidiDeviceCache {
+public:
+    // All keyboards with both ports listed, ordered by input port
+    const std::vector<KkMidiDevices>& find();
+    // True if the ports of devices are still listed with the names of the same keyboard. Reads the device counts and
+    // these two names only, for watching a connected keyboard without going through the whole table.
+    static bool isListed(const KkMidiDevices& devices);
+    // Forces matching on the next find()
+    void invalidate() { valid = false; }
+    // Number of times the table was matched (i.e. found changed), for diagnostics
+    unsigned int matchCount() const { return matches; }
+
+private:
+    void readName(int dev, bool input, std::string& nameOut, uint64_t& hash);
+    void match();
+
+    std::vector<std::string> inputNames; // empty string: device not present
+    std::vector<std::string> outputNames;
+    uint64_t fingerprint = 0;
+    bool valid = false;
+    unsigned int matches = 0;
+    std::vector<KkMidiDevices> keyboards;
+};
@@ -1,15 +1,69 @@
 #include "MidiSender.h"
 #include "Commands.h"
 #include "reaKontrol.h"
+#include "MidiTrace.h"
 #include <cstring>
 #include <sstream>
 #include <reaper/reaper_plugin_functions.h>
 
-MidiSender::MidiSender(midi_Output* output) : _output(output) {}
+namespace {
+    constexpr uint32_t BATCH_SYSEX = 0x10000;
+
+    uint32_t ccKey(unsigned char command) {
+        return command;
+    }
+
+    uint32_t sysexKey(unsigned char command, unsigned char track) {
+        return BATCH_SYSEX | (static_cast<uint32_t>(command) << 8) | track;
+    }
+}
+
+MidiSender::MidiSender(midi_Output* output, unsigned char traceSurface) : _output(output), traceSurface(traceSurface) {}
+
+void MidiSender::beginBatch() {
+    batching = true;
+}
+
+void MidiSender::flushBatch() {
+    batching = false;
+    for (const auto& entry : batch) {
+        unsigned char command = static_cast<unsigned char>(entry.first >> 8);
+        unsigned char value = static_cast<unsigned char>(entry.second[0]);
+        if (entry.first & BATCH_SYSEX) {
+            sendSysex(command, value, static_cast<unsigned char>(entry.first & 0xFF), entry.second.substr(1));
+        }
+        else {
+            sendCc(static_cast<unsigned char>(entry.first), value);
+        }
+    }
+    batch.clear();
+    batchIndex.clear();
+}
+
+void MidiSender::storeInBatch(uint32_t key, unsigned char value, const std::string& info) {
+    auto it = batchIndex.find(key);
+    if (it == batchIndex.end()) {
+        batchIndex[key] = batch.size();
+        batch.emplace_back(key, std::string());
+        it = batchIndex.find(key);
+    }
+    std::string& payload = batch[it->second].second;
+    payload.assign(1, static_cast<char>(value));
+    payload += info;
+}
 
 void MidiSender::sendCc(unsigned char command, unsigned char value) {
+    if (batching) {
+        storeInBatch(ccKey(command), value, std::string());
+        return;
+    }
     if (_output) {
         _output->Send(MIDI_CC, command, value, -1);
+        updateShadow(ccKey(command), value, nullptr, 0);
+        if (g_midiTrace) {
+            const unsigned char msg[3] = { MIDI_CC, command, value };
+            g_midiTrace->record(TRACE_OUT, traceSurface, msg, sizeof(msg));
+        }
     }
 }
 
@@ -17,41 +71,96 @@ void MidiSender::sendSysex(unsigned char command,
     unsigned char value,
     unsigned char track,
     const std::string& info) {
+    if (batching) {
+        storeInBatch(sysexKey(command, track), value, info);
+        return;
+    }
     if (!_output) return;
+    frameBuffer.clear();
+    encodeSysex(frameBuffer, command, value, track, info);
+    sendFrame(frameBuffer.data(), frameBuffer.size(), false);
+}
 
-    size_t sysexBeginSize = sizeof(MIDI_SYSEX_BEGIN);
-    size_t infoLength = info.length();
-    size_t length = sysexBeginSize + 3 + infoLength + 1; // 3 for command, value, track; 1 for MIDI_SYSEX_END
-
-    // Allocate memory for MIDI_event_t with the appropriate size
-    MIDI_event_t* event = reinterpret_cast<MIDI_event_t*>(
-        new unsigned char[sizeof(MIDI_event_t) - 4 + length]);
-
-    event->frame_offset = 0;
-    event->size = static_cast<int>(length); // Explicit cast to suppress warning
-
-    // Copy the SysEx header
-    memcpy(event->midi_message, MIDI_SYSEX_BEGIN, sysexBeginSize);
-    size_t pos = sysexBeginSize;
+void MidiSender::encodeCc(std::vector<unsigned char>& buffer, unsigned char command, unsigned char value) {
+    buffer.push_back(MIDI_CC);
+    buffer.push_back(command);
+    buffer.push_back(value);
+}
 
-    // Add command, value, and track
-    event->midi_message[pos++] = command;
-    event->midi_message[pos++] = value;
-    event->midi_message[pos++] = track;
+void MidiSender::encodeSysex(std::vector<unsigned char>& buffer,
+    unsigned char command,
+    unsigned char value,
+    unsigned char track,
+    const std::string& info) {
+    buffer.insert(buffer.end(), MIDI_SYSEX_BEGIN, MIDI_SYSEX_BEGIN + sizeof(MIDI_SYSEX_BEGIN));
+    buffer.push_back(command);
+    buffer.push_back(value);
+    buffer.push_back(track);
+    buffer.insert(buffer.end(), info.begin(), info.end());
+    buffer.push_back(MIDI_SYSEX_END);
+}
 
-    // Copy additional info if present
-    if (!info.empty()) {
-        memcpy(event->midi_message + pos, info.c_str(), infoLength);
-        pos += infoLength;
+void MidiSender::sendEncoded(const std::vector<unsigned char>& buffer) {
+    size_t pos = 0;
+    while (pos < buffer.size()) {
+        size_t size;
+        if (buffer[pos] == MIDI_CC) {
+            size = 3;
+        }
+        else {
+            const void* end = memchr(&buffer[pos], MIDI_SYSEX_END, buffer.size() - pos);
+            if (!end) return; // not made by encodeSysex()
+            size = static_cast<const unsigned char*>(end) - &buffer[pos] + 1;
+        }
+        if (pos + size > buffer.size()) return;
+        sendFrame(&buffer[pos], size, true);
+        pos += size;
     }
+}
 
-    // Append SysEx end byte
-    event->midi_message[pos++] = MIDI_SYSEX_END;
+// Records the message as shown on the keyboard display, returns false if it already was
+bool MidiSender::updateShadow(uint32_t key, unsigned char value, const char* info, size_t infoLength) {
+    std::string& shown = shadow[key];
+    if (!shown.empty() && static_cast<unsigned char>(shown[0]) == value && shown.size() == infoLength + 1 &&
+        (infoLength == 0 || memcmp(shown.data() + 1, info, infoLength) == 0)) {
+        return false;
+    }
+    shown.assign(1, static_cast<char>(value));
+    shown.append(info, infoLength);
+    return true;
+}
 
-    // Send the MIDI message
+void MidiSender::sendFrame(const unsigned char* msg, size_t size, bool skipShown) {
+    if (size == 3 && msg[0] == MIDI_CC) {
+        if (skipShown && !batching && _output) {
+            auto it = shadow.find(ccKey(msg[1]));
+            if (it != shadow.end() && it->second.size() == 1 && static_cast<unsigned char>(it->second[0]) == msg[2]) {
+                return;
+            }
+        }
+        sendCc(msg[1], msg[2]);
+        return;
+    }
+    const size_t header = sizeof(MIDI_SYSEX_BEGIN) + 3;
+    if (size < header + 1) return;
+    const unsigned char command = msg[header - 3];
+    const unsigned char value = msg[header - 2];
+    const unsigned char track = msg[header - 1];
+    const char* info = reinterpret_cast<const char*>(msg) + header;
+    const size_t infoLength = size - header - 1;
+    if (batching) {
+        storeInBatch(sysexKey(command, track), value, std::string(info, infoLength));
+        return;
+    }
+    if (!_output) return;
+    if (!updateShadow(sysexKey(command, track), value, info, infoLength) && skipShown) return;
+    eventBuffer.resize(sizeof(MIDI_event_t) - 4 + size);
+    MIDI_event_t* event = reinterpret_cast<MIDI_event_t*>(eventBuffer.data());
+    event->frame_offset = 0;
+    event->size = static_cast<int>(size);
+    memcpy(event->midi_message, msg, size);
     _output->SendMsg(event, -1);
-
-    // Clean up allocated memory
-    delete[] reinterpret_cast<unsigned char*>(event);
+    if (g_midiTrace) {
+        g_midiTrace->record(TRACE_OUT, traceSurface, event->midi_message, size);
+    }
 }
-
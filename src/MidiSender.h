@@ -1,12 +1,29 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 class midi_Output;
 
 class MidiSender {
 public:
-    explicit MidiSender(midi_Output* output);
+    // traceSurface: index of the surface in MIDI session captures (see MidiTrace.h)
+    explicit MidiSender(midi_Output* output, unsigned char traceSurface = 0);
+
+    // The sender lives as long as the surface, the port changes with every (re)connect. Without a port nothing is sent.
+    void setOutput(midi_Output* output) {
+        _output = output;
+        shadow.clear(); // new port, nothing known about the display
+    }
+    bool hasOutput() const { return _output != nullptr; }
+
+    // Display batch: between beginBatch() and flushBatch() messages only update a model of the keyboard display (one
+    // entry per CC command and per SysEx command and track, in order of first use). flushBatch() then sends every
+    // entry once with its final value, so a full resync doesn't send anything twice.
+    void beginBatch();
+    void flushBatch();
 
     void sendCc(unsigned char command, unsigned char value);
 
@@ -15,6 +32,31 @@ public:
                    unsigned char track,
                    const std::string& info = "");
 
+    // Pre-encoded messages: encodeCc() / encodeSysex() append a message to buffer exactly as it goes over the wire,
+    // sendEncoded() sends a buffer of such messages without building anything (inside a display batch they are
+    // stored in the batch like any other message). Messages the keyboard display already shows are skipped.
+    static void encodeCc(std::vector<unsigned char>& buffer, unsigned char command, unsigned char value);
+    static void encodeSysex(std::vector<unsigned char>& buffer,
+                            unsigned char command,
+                            unsigned char value,
+                            unsigned char track,
+                            const std::string& info = "");
+    void sendEncoded(const std::vector<unsigned char>& buffer);
+
+    // Forget what the keyboard display shows, the next sendEncoded() sends everything again
+    void invalidateShadow() { shadow.clear(); }
+
 private:
+    void storeInBatch(uint32_t key, unsigned char value, const std::string& info);
+    void sendFrame(const unsigned char* msg, size_t size, bool skipShown);
+    bool updateShadow(uint32_t key, unsigned char value, const char* info, size_t infoLength);
+
     midi_Output* _output;
+    unsigned char traceSurface;
+    bool batching = false;
+    std::vector<std::pair<uint32_t, std::string>> batch; // key, value byte followed by the SysEx info
+    std::unordered_map<uint32_t, size_t> batchIndex;
+    std::vector<unsigned char> frameBuffer; // sendSysex() message, reused
+    std::vector<unsigned char> eventBuffer; // MIDI_event_t, reused
+    std::unordered_map<uint32_t, std::string> shadow; // Last message sent per batch key: value byte and SysEx info
 };
@@ -0,0 +1,197 @@
+#include "MidiTrace.h"
+#include "TimerWheel.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MidiTraceWriter* g_midiTrace = nullptr;
+
+namespace {
+    constexpr size_t TRACE_CHUNK = 4 * 1024 * 1024; // file grows in steps of 4 MiB
+
+    void putU16(unsigned char* p, uint32_t v) {
+        p[0] = static_cast<unsigned char>(v & 0xFF);
+        p[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+    }
+
+    void putU32(unsigned char* p, uint32_t v) {
+        putU16(p, v & 0xFFFF);
+        putU16(p + 2, v >> 16);
+    }
+
+    uint32_t getU16(const unsigned char* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    uint32_t getU32(const unsigned char* p) {
+        return getU16(p) | (getU16(p + 2) << 16);
+    }
+}
+
+MidiTraceWriter::MidiTraceWriter() {}
+
+MidiTraceWriter::~MidiTraceWriter() {
+    close();
+}
+
+bool MidiTraceWriter::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    file = h;
+#else
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+#endif
+    filePath = path;
+    if (!map(TRACE_CHUNK)) {
+        close();
+        return false;
+    }
+    memcpy(base, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    memset(base + sizeof(TRACE_MAGIC), 0, TRACE_HEADER_SIZE - sizeof(TRACE_MAGIC));
+    used = TRACE_HEADER_SIZE;
+    last = monotonicUs();
+    return true;
+}
+
+void MidiTraceWriter::close() {
+    unmap();
+#ifdef _WIN32
+    if (file) {
+        // Cut off the unused part of the last chunk
+        LARGE_INTEGER size;
+        size.QuadPart = static_cast<LONGLONG>(used);
+        SetFilePointerEx(file, size, nullptr, FILE_BEGIN);
+        SetEndOfFile(file);
+        CloseHandle(file);
+        file = nullptr;
+    }
+#else
+    if (fd >= 0) {
+        if (ftruncate(fd, static_cast<off_t>(used)) != 0) {
+            // nothing sensible left to do, the trace is still readable up to the last complete record
+        }
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    used = 0;
+    capacity = 0;
+}
+
+void MidiTraceWriter::record(unsigned char type, unsigned char surface, const unsigned char* msg, size_t size) {
+    if (!base) return;
+    if (size > 0xFFFF) size = 0xFFFF;
+    if (!reserve(TRACE_RECORD_HEADER_SIZE + size)) return;
+
+    uint64_t now = monotonicUs(); // same clock as the surface's timers, so replays reproduce their timing
+    uint64_t delta = now - last;
+    last = now;
+
+    unsigned char* p = base + used;
+    p[0] = type;
+    p[1] = surface;
+    putU16(p + 2, static_cast<uint32_t>(size));
+    putU32(p + 4, delta > 0xFFFFFFFF ? 0xFFFFFFFF : static_cast<uint32_t>(delta));
+    if (size) {
+        memcpy(p + TRACE_RECORD_HEADER_SIZE, msg, size);
+    }
+    used += TRACE_RECORD_HEADER_SIZE + size;
+}
+
+bool MidiTraceWriter::reserve(size_t size) {
+    if (used + size <= capacity) return true;
+    size_t keep = used;
+    unmap();
+    used = keep;
+    if (!map(capacity + TRACE_CHUNK)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MidiTraceWriter::map(size_t size) {
+#ifdef _WIN32
+    HANDLE m = CreateFileMappingA(file, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+    if (!m) return false;
+    void* view = MapViewOfFile(m, FILE_MAP_WRITE, 0, 0, size);
+    if (!view) {
+        CloseHandle(m);
+        return false;
+    }
+    mapping = m;
+    base = static_cast<unsigned char*>(view);
+#else
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) return false;
+    void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) return false;
+    base = static_cast<unsigned char*>(view);
+#endif
+    capacity = size;
+    return true;
+}
+
+void MidiTraceWriter::unmap() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(base, capacity);
+#endif
+    base = nullptr;
+}
+
+bool readMidiTrace(const std::string& path, std::vector<MidiTraceRecord>& records) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const size_t magicSize = sizeof(TRACE_MAGIC) - 1; // without the version
+    if (data.size() < TRACE_HEADER_SIZE || memcmp(data.data(), TRACE_MAGIC, magicSize) != 0) {
+        return false;
+    }
+    unsigned char version = data[magicSize];
+    if (version != 1 && version != TRACE_MAGIC[magicSize]) {
+        return false;
+    }
+    const size_t headerSize = (version == 1) ? TRACE_RECORD_HEADER_SIZE - 1 : TRACE_RECORD_HEADER_SIZE;
+    const size_t fields = (version == 1) ? 1 : 2; // offset of length and time
+
+    records.clear();
+    uint64_t timeUs = 0;
+    size_t pos = TRACE_HEADER_SIZE;
+    while (pos + headerSize <= data.size()) {
+        const unsigned char* p = &data[pos];
+        size_t size = getU16(p + fields);
+        if (p[0] == 0 || pos + headerSize + size > data.size()) {
+            break; // zero filled tail of a trace that was not closed properly
+        }
+        timeUs += getU32(p + fields + 2);
+        MidiTraceRecord record;
+        record.type = p[0];
+        record.surface = (version == 1) ? 0 : p[1];
+        record.timeUs = timeUs;
+        record.msg.assign(p + headerSize, p + headerSize + size);
+        records.push_back(std::move(record));
+        pos += headerSize + size;
+    }
+    return true;
+}
+
+void filterMidiTrace(std::vector<MidiTraceRecord>& records, unsigned char surface) {
+    records.erase(std::remove_if(records.begin(), records.end(),
+        [surface](const MidiTraceRecord& record) { return record.surface != surface; }), records.end());
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Binary MIDI session trace
+// File layout: 16 byte header ("RKTRACE" + format version + 8 reserved bytes), followed by records of
+//   uint8 type | uint8 surface | uint16 length (LE) | uint32 microseconds since previous record (LE) | length bytes MIDI message
+// All surfaces (one per keyboard) write into the same trace, surface is the index of the one that recorded it.
+// Version 1 traces have no surface byte, their records all belong to surface 0.
+// The writer appends into a memory-mapped file that grows in chunks and is truncated to its real size on close.
+
+constexpr unsigned char TRACE_TICK = 1; // BaseSurface::Run() invocation, no payload
+constexpr unsigned char TRACE_IN = 2; // MIDI message received from the keyboard
+constexpr unsigned char TRACE_OUT = 3; // MIDI message sent to the keyboard
+
+constexpr char TRACE_MAGIC[8] = { 'R', 'K', 'T', 'R', 'A', 'C', 'E', 2 };
+constexpr size_t TRACE_HEADER_SIZE = 16;
+constexpr size_t TRACE_RECORD_HEADER_SIZE = 8;
+
+class MidiTraceWriter {
+public:
+    MidiTraceWriter();
+    ~MidiTraceWriter();
+
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return base != nullptr; }
+    const std::string& path() const { return filePath; }
+
+    void record(unsigned char type, unsigned char surface, const unsigned char* msg = nullptr, size_t size = 0);
+
+private:
+    bool reserve(size_t size);
+    bool map(size_t size);
+    void unmap();
+
+    std::string filePath;
+    unsigned char* base = nullptr;
+    size_t used = 0;
+    size_t capacity = 0;
+    uint64_t last = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+struct MidiTraceRecord {
+    unsigned char type;
+    unsigned char surface;
+    uint64_t timeUs; // since start of trace
+    std::vector<unsigned char> msg;
+};
+
+// Reads a complete trace file, returns false if the file is missing or not a trace
+bool readMidiTrace(const std::string& path, std::vector<MidiTraceRecord>& records);
+// Keeps the records of one surface only, their times stay relative to the start of the trace
+void filterMidiTrace(std::vector<MidiTraceRecord>& records, unsigned char surface);
+
+// Capture mode: when set, BaseSurface::Run() and MidiSender record every inbound and outbound message
+extern MidiTraceWriter* g_midiTrace;
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <unordered_set>
+#include <string>
 #include "NiMidiSurface.h"
 #include "reaKontrol.h"
 #include "Constants.h"
@@ -13,14 +15,6 @@ enum CycleDirection {
     COUNTER_CLOCKWISE
 };
 
-struct MidiEventData {
-    unsigned char value;
-    int timer;
-};
-
-static int timer = 0;
-static std::unordered_map<unsigned char, std::vector<MidiEventData>> eventMap;
-
 std::unordered_set<unsigned char> doubleClickCommands = {
     CMD_PLAY_CLIP,
     CMD_PLAY,
@@ -29,26 +23,34 @@ std::unordered_set<unsigned char> doubleClickCommands = {
     CMD_REC
 };
 
-NiMidiSurface::NiMidiSurface()
-    : midiSender(nullptr), processor(nullptr) {
-    g_connectedState = KK_NOT_CONNECTED;
+// Keyboards in use by a surface (see KkMidiDevices::keyboard). Only touched when a surface connects or disconnects.
+static std::unordered_set<std::string> claimedKeyboards;
+
+NiMidiSurface::NiMidiSurface(unsigned char surfaceIndex)
+    : BaseSurface(surfaceIndex), midiSender(new MidiSender(nullptr, surfaceIndex)), processor(nullptr) {
+    // Sender and processor live as long as the surface, only the MIDI ports come and go with the keyboard
+    processor = new CommandProcessor(ctx, *midiSender, this);
+    ctx.connectedState = KK_NOT_CONNECTED;
+    scanInterval = SCAN_MS;
+    backoffRng.seed(static_cast<unsigned int>(monotonicMs()));
+    // Scan for the keyboard right away, retries back off (see nextScanDelay)
+    scheduleConnectAttempt(0);
 }
 
 NiMidiSurface::~NiMidiSurface() {
-    for (int i = 0; i < 8; ++i) {
-        if (midiSender) {
+    if (midiSender->hasOutput()) {
+        for (int i = 0; i < 8; ++i) {
             midiSender->sendSysex(CMD_TRACK_AVAIL, 0, i);
         }
-    }
-    if (midiSender) {
         midiSender->sendCc(CMD_GOODBYE, 0);
     }
+    closeMidiPorts();
     delete processor;
     delete midiSender;
     processor = nullptr;
     midiSender = nullptr;
-    protocolVersion = 0;
-    g_connectedState = KK_NOT_CONNECTED;
+    ctx.protocolVersion = 0;
+    ctx.connectedState = KK_NOT_CONNECTED;
 }
 
 MidiSender* NiMidiSurface::GetMidiSender() {
@@ -64,191 +66,344 @@ const char* NiMidiSurface::GetDescString() {
 }
 
 void NiMidiSurface::Run() {
-    static int inDev = -1;
-    static int outDev = -1;
-
-    static bool lightOn = false;
-    static int flashTimer = -1; // EXT_EDIT_OFF: flashTimer = -1
-    static int cycleTimer = -1;
-    static int cyclePos = 0;
-
-    if (g_connectedState == KK_NOT_CONNECTED) {
-        scanTimer++;
-        if (scanTimer >= SCAN_T) {
-            scanTimer = 0;
-            inDev = getKkMidiInput();
-            if (inDev != -1) {
-                outDev = getKkMidiOutput();
-                if (outDev != -1) {
-                    this->_midiIn = CreateMIDIInput(inDev);
-                    this->_midiOut = CreateMIDIOutput(outDev, false, nullptr);
-                    if (this->_midiOut) {
-                        this->_midiIn->start();
-                        midiSender = new MidiSender(this->_midiOut);
-                        if (!processor) {
-                            processor = new CommandProcessor(*midiSender);
-                        }
-                        g_connectedState = KK_MIDI_FOUND;
-                        scanTimer = SCAN_T;
-                    }
-                }
-            }
-        }
-    }
-    else if (g_connectedState == KK_MIDI_FOUND) {
+    // Fire everything that is due: scan retries, LED flashing and cycling, click timeouts, selection debounce
+    timers.advance();
+
+    if (ctx.connectedState == KK_MIDI_FOUND) {
         BaseSurface::Run();
-        scanTimer++;
-        if (scanTimer >= SCAN_T) {
-            scanTimer = 0;
-            if (connectCount < CONNECT_N) {
-                connectCount++;
-                midiSender->sendCc(CMD_HELLO, 3);
-            }
-            else {
-                int answer = ShowMessageBox("Komplete Kontrol Keyboard detected but failed to connect. Please restart NI services (NIHostIntegrationAgent), then retry.", "ReaKontrol", 5);
-                if (this->_midiIn) {
-                    this->_midiIn->stop();
-                    delete this->_midiIn;
-                }
-                if (this->_midiOut) {
-                    delete this->_midiOut;
-                }
-                connectCount = 0;
-                g_connectedState = (answer == 4) ? KK_NOT_CONNECTED : -1;
-            }
-        }
     }
-    else if (g_connectedState == KK_NIHIA_CONNECTED) {
+    else if (ctx.connectedState == KK_NIHIA_CONNECTED) {
         /*----------------- We are successfully connected -----------------*/
         if (!g_actionListLoaded) {
             loadConfigFile();
             g_actionListLoaded = true;
         }
 
-        if (getExtEditMode() == EXT_EDIT_OFF) {
-            if (flashTimer != -1) {
-                
-                this->updateTransportAndNavButtons();
-                allMixerUpdate(midiSender);
-                peakMixerUpdate(midiSender);
-
-                lightOn = false;
-                // One time update
-                flashTimer = -1;
-                cycleTimer = -1;
-                cyclePos = 0;
-            }
+        if (ctx.getExtEditMode() != editModeShown) {
+            enterEditMode(ctx.getExtEditMode());
         }
-        else if (getExtEditMode() == EXT_EDIT_ON) {
-            cycleEncoderLEDs(cycleTimer, cyclePos, CLOCKWISE, midiSender);
+
+        // Bank filters changed in the config file: lay out the banks anew as for a changed track list
+        if (ctx.bank.filterChanged()) {
+            SetTrackListChange();
         }
-        else if (getExtEditMode() == EXT_EDIT_LOOP) {
-            if (cycleTimer == -1) {
-                debugLog("RUN: EXT_EDIT_LOOP");
-                this->updateTransportAndNavButtons();
-                peakMixerUpdate(midiSender);
-                midiSender->sendCc(CMD_NAV_TRACKS, 1);
-                midiSender->sendCc(CMD_NAV_CLIPS, 0);
-            }
-            cycleEncoderLEDs(cycleTimer, cyclePos, CLOCKWISE, midiSender);
-            
-            // Flash LOOP button
-            flashTimer += 1;
-            if (flashTimer >= FLASH_T) {
-                flashTimer = 0;
-                lightOn = !lightOn;
-                const unsigned char onOff = lightOn ? 1 : 0;
-                midiSender->sendCc(CMD_LOOP, onOff);
-            }
+
+        // Selection, automation mode and name changes reported since the last tick
+        processSelectedTracks();
+
+        // Continuesly updating peak info, in FX and routing mode the shown values instead (search results have none)
+        if (ctx.getExtEditMode() == EXT_EDIT_FX) {
+            fxParamUpdate(ctx, midiSender);
         }
-        else if (getExtEditMode() == EXT_EDIT_TEMPO) {
-            if (cycleTimer == -1) {
-                debugLog("RUN: EXT_EDIT_TEMPO");
-                this->updateTransportAndNavButtons();
-                peakMixerUpdate(midiSender);
-                midiSender->sendCc(CMD_NAV_TRACKS, 1);
-                midiSender->sendCc(CMD_NAV_CLIPS, 0);
-            }
-            
-            cycleEncoderLEDs(cycleTimer, cyclePos, COUNTER_CLOCKWISE, midiSender);
-            
-            // Flash METRO button
-            flashTimer += 1;
-            if (flashTimer >= FLASH_T) {
-                flashTimer = 0;
-                lightOn = !lightOn;
-                const unsigned char onOff = lightOn ? 1 : 0;
-                midiSender->sendCc(CMD_METRO, onOff);
-            }
+        else if (ctx.getExtEditMode() == EXT_EDIT_SENDS) {
+            routePageUpdate(ctx, midiSender);
         }
-
-        // Continuesly updating peak info
-        if (getExtEditMode() != EXT_EDIT_ON) {
-            peakMixerUpdate(midiSender);
+        else if (ctx.getExtEditMode() != EXT_EDIT_ON && !ctx.mixerHidden()) {
+            peakMixerUpdate(ctx, midiSender);
         }
 
-        // Fallback to master track when no track is selected
-        if (trackDebouncer.shouldFallbackToMaster()) {
-            g_trackInFocus = 0; // master track
-            debugLog("[Debounce] Fallback to master track (no selection)");
-            trackDebouncer.reset(); // clean after decision
+        // The cursor moves on its own while playing: up / down light for the markers around it. Only sent
+        // when it changed, the other modes animate these lights and resync them on leaving.
+        if (ctx.getExtEditMode() == EXT_EDIT_OFF && editModeShown == EXT_EDIT_OFF) {
+            positionTextUpdate(ctx, midiSender); // marker / item name shown long enough
+            unsigned char lights = clipNavLights(ctx);
+            if (lights != ctx.clipLightsShown) {
+                ctx.clipLightsShown = lights;
+                midiSender->sendCc(CMD_NAV_CLIPS, lights);
+            }
         }
 
-        // Timer (eg: for double click detection)
-        timer++;
-        processClickEvent();
-        
         BaseSurface::Run();
     }
+    ctx.publish();
 }
 
-void NiMidiSurface::processClickEvent()
-{
-    if (!eventMap.empty()) {
-        for (auto it = eventMap.begin(); it != eventMap.end(); ++it) {
-            unsigned char command = it->first;
-            std::vector<MidiEventData>& events = it->second;
-
-            // If there are multiple events for the same command, treat it as a double-click
-            if (events.size() > 1) {
-                debugLog("Double Click Event '" + std::to_string(command) + "' with " + std::to_string(events.size()) + " events");
-                auto value = events.back().value;
-
-                // Clear all events for this command after double-click processing
-                it->second.clear();
-                nextOpenTimer = timer + CLICK_COOLDOWN;
-
-                // Process the double-click
-                static CommandProcessor processor(*midiSender);
-                processor.Handle(command, value, EVENT_CLICK_DOUBLE); // Use last event for double-click
+void NiMidiSurface::Reconnect() {
+    if (ctx.connectedState == KK_NIHIA_CONNECTED) {
+        return;
+    }
+    debugLog("Reconnect requested");
+    scanInterval = SCAN_MS;
+    failureReported = false;
+    devices.invalidate();
+    if (ctx.connectedState == KK_MIDI_FOUND) {
+        ctx.connectCount = 0; // start the handshake over
+    }
+    scheduleConnectAttempt(0);
+}
+
+void NiMidiSurface::scheduleConnectAttempt(unsigned int delayMs) {
+    timers.cancel(connectTimer);
+    connectTimer = timers.schedule(delayMs, [this]() { this->onConnectTimer(); });
+}
+
+unsigned int NiMidiSurface::nextScanDelay() {
+    // Exponential backoff up to SCAN_MAX_MS with +-20% jitter, so a machine without the keyboard hardly ever scans
+    // and several surfaces don't probe the devices in lockstep
+    unsigned int delay = scanInterval;
+    scanInterval = (scanInterval >= SCAN_MAX_MS / 2) ? SCAN_MAX_MS : scanInterval * 2;
+    unsigned int jitter = delay / 5;
+    return delay - jitter + backoffRng() % (2 * jitter + 1);
+}
+
+void NiMidiSurface::onConnectTimer() {
+    if (ctx.connectedState == KK_NOT_CONNECTED) {
+        // Take the first keyboard no other surface is using
+        KkMidiDevices found;
+        for (const KkMidiDevices& keyboard : devices.find()) {
+            if (!claimedKeyboards.count(keyboard.keyboard)) {
+                found = keyboard;
+                break;
             }
-            else if (events.size() == 1) {
-                // If there's only one event, check for timeout
-                MidiEventData& eventData = events.front();  // Get the single event
-
-                if (timer - eventData.timer > DOUBLE_CLICK_THRESHOLD) {
-                    // Event has expired (no second event arrived within the threshold), treat it as a single-click
-                    debugLog("Single Click Event '" + std::to_string(command) + "': timed out");
-                    auto value = eventData.value;
-
-                    // Clear all events for this command after single-click processing
-                    it->second.clear();
-                    nextOpenTimer = timer + CLICK_COOLDOWN;
-
-                    // Process the single-click logic
-                    static CommandProcessor processor(*midiSender);
-                    processor.Handle(command, value, EVENT_CLICK_SINGLE);
-                }
+        }
+        if (!found.found()) {
+            scheduleConnectAttempt(nextScanDelay());
+            return;
+        }
+        this->_midiIn = CreateMIDIInput(found.input);
+        this->_midiOut = CreateMIDIOutput(found.output, false, nullptr);
+        if (!this->_midiIn || !this->_midiOut) {
+            closeMidiPorts();
+            scheduleConnectAttempt(nextScanDelay());
+            return;
+        }
+        this->_midiIn->start();
+        midiSender->setOutput(this->_midiOut);
+        openDevices = found;
+        claimedKeyboards.insert(found.keyboard);
+        debugLog("Keyboard found: " + found.keyboard);
+        ctx.connectedState = KK_MIDI_FOUND;
+        ctx.connectCount = 0;
+        // Fall through: say hello right away
+    }
+
+    if (ctx.connectedState == KK_MIDI_FOUND) {
+        if (ctx.connectCount < CONNECT_N) {
+            ctx.connectCount++;
+            midiSender->sendCc(CMD_HELLO, 3);
+            scheduleConnectAttempt(SCAN_MS);
+        }
+        else {
+            // NIHIA doesn't answer. Never block REAPER with a modal dialog from within Run(): report once on the
+            // console, release the ports and keep retrying in the background with growing intervals.
+            if (!failureReported) {
+                ShowConsoleMsg("ReaKontrol: Komplete Kontrol Keyboard detected but failed to connect. Please restart NI services "
+                    "(NIHostIntegrationAgent). Retrying in the background, run the action "
+                    "\"ReaKontrol: Reconnect Komplete Kontrol Keyboard\" to retry immediately.\n");
+                failureReported = true;
             }
+            closeMidiPorts();
+            ctx.connectCount = 0;
+            ctx.connectedState = KK_NOT_CONNECTED;
+            scheduleConnectAttempt(nextScanDelay());
+        }
+    }
+}
+
+void NiMidiSurface::closeMidiPorts() {
+    midiSender->setOutput(nullptr);
+    if (openDevices.found()) {
+        claimedKeyboards.erase(openDevices.keyboard);
+    }
+    openDevices = KkMidiDevices();
+    if (this->_midiIn) {
+        this->_midiIn->stop();
+        delete this->_midiIn;
+        this->_midiIn = nullptr;
+    }
+    if (this->_midiOut) {
+        delete this->_midiOut;
+        this->_midiOut = nullptr;
+    }
+}
+
+void NiMidiSurface::checkLiveness() {
+    // NIHIA sends nothing while idle, so watch the device table instead: REAPER stops reporting the name of an
+    // unplugged device. Only the two ports of this keyboard are read, not the whole table.
+    if (MidiDeviceCache::isListed(openDevices)) {
+        return;
+    }
+    debugLog("Keyboard lost: " + openDevices.keyboard);
+    disconnect();
+}
+
+void NiMidiSurface::disconnect() {
+    // Orderly teardown: nothing of the old connection survives, the keyboard forgets its display anyway
+    timers.cancel(livenessTimer);
+    timers.cancel(flashTimer);
+    timers.cancel(cycleTimer);
+    timers.cancel(actionTimer);
+    timers.cancel(debounceTimer);
+    for (auto& click : pendingClicks) {
+        timers.cancel(click.second.timeout);
+    }
+    pendingClicks.clear();
+    selectedDirty.clear();
+    closeMidiPorts();
+    ctx.setExtEditMode(EXT_EDIT_OFF);
+    editModeShown = EXT_EDIT_OFF;
+    ctx.protocolVersion = 0;
+    ctx.connectCount = 0;
+    ctx.connectedState = KK_NOT_CONNECTED;
+    // Usually the keyboard is plugged back in soon, start the backoff over
+    scanInterval = SCAN_MS;
+    failureReported = false;
+    scheduleConnectAttempt(nextScanDelay());
+}
+
+void NiMidiSurface::resync() {
+    debugLog("resync");
+    // Everything the keyboard shows, taken from REAPER's current state: the project may have changed while the
+    // keyboard was away (no surface callbacks are handled then). Batched, so every field is sent exactly once.
+    int numTracks = CSurf_NumTracks(false);
+    if (ctx.state.trackInFocus > numTracks) {
+        ctx.state.trackInFocus = numTracks;
+    }
+    ctx.bank.invalidate(); // tracks may have been hidden or regrouped meanwhile
+    int lastPos = ctx.bank.size() - 1;
+    if (ctx.state.bankStart > lastPos) {
+        ctx.state.bankStart = lastPos - lastPos % BANK_NUM_TRACKS;
+    }
+    ctx.state.anySolo = AnyTrackSolo(nullptr);
+
+    midiSender->beginBatch();
+    // Turn on button lights
+    midiSender->sendCc(CMD_UNDO, 1);
+    midiSender->sendCc(CMD_REDO, 1);
+    midiSender->sendCc(CMD_CLEAR, 1);
+    midiSender->sendCc(CMD_QUANTIZE, 1);
+    int playState = GetPlayState();
+    sendTransportLights((playState & 1) != 0, (playState & 2) != 0, (playState & 4) != 0);
+    allMixerUpdate(ctx, midiSender);
+    updateTransportAndNavButtons();
+    UpdateMixerScreenEncoder(ctx.state.trackInFocus);
+    updateAutoLight(CSurf_TrackFromID(ctx.state.trackInFocus, false), ctx.state.trackInFocus);
+    midiSender->flushBatch();
+}
+
+void NiMidiSurface::enterEditMode(int mode) {
+    int previous = editModeShown;
+    editModeShown = mode;
+    timers.cancel(flashTimer);
+    timers.cancel(cycleTimer);
+    timers.cancel(actionTimer);
+    lightOn = false;
+    cyclePos = 0;
+
+    if (mode == EXT_EDIT_OFF) {
+        // One time update
+        this->updateTransportAndNavButtons();
+        if (previous == EXT_EDIT_LOOP || previous == EXT_EDIT_TEMPO || previous == EXT_EDIT_FX || previous == EXT_EDIT_SENDS ||
+            previous == EXT_EDIT_SEARCH) {
+            allMixerUpdate(ctx, midiSender);
+            peakMixerUpdate(ctx, midiSender);
+        }
+        if (previous == EXT_EDIT_SEARCH) {
+            UpdateMixerScreenEncoder(ctx.state.trackInFocus); // the M button flashed
         }
+        if (previous == EXT_EDIT_FX) {
+            updateAutoLight(CSurf_TrackFromID(ctx.state.trackInFocus, false), ctx.state.trackInFocus); // AUTO flashed
+        }
+        if (previous == EXT_EDIT_SENDS) {
+            midiSender->sendCc(CMD_QUANTIZE, 1); // QUANTIZE flashed, it is always lit otherwise
+        }
+    }
+    else if (mode == EXT_EDIT_ON) {
+        cycleTimer = timers.schedule(CYCLE_MS, [this]() { this->cycleEncoderLEDs(CLOCKWISE); }, CYCLE_MS);
+        // Toggle actions on the shown page (metronome, SWS toggles...) may be switched from anywhere
+        actionTimer = timers.schedule(ACTION_TOGGLE_MS, [this]() {
+            updateActionToggles(midiSender, ctx.actionPage);
+        }, ACTION_TOGGLE_MS);
+    }
+    else if (mode == EXT_EDIT_LOOP || mode == EXT_EDIT_TEMPO) {
+        debugLog(mode == EXT_EDIT_LOOP ? "RUN: EXT_EDIT_LOOP" : "RUN: EXT_EDIT_TEMPO");
+        this->updateTransportAndNavButtons();
+        peakMixerUpdate(ctx, midiSender);
+        midiSender->sendCc(CMD_NAV_TRACKS, 1);
+        midiSender->sendCc(CMD_NAV_CLIPS, 0);
+
+        CycleDirection direction = (mode == EXT_EDIT_LOOP) ? CLOCKWISE : COUNTER_CLOCKWISE;
+        cycleTimer = timers.schedule(CYCLE_MS, [this, direction]() { this->cycleEncoderLEDs(direction); }, CYCLE_MS);
+
+        // Flash LOOP or METRO button
+        unsigned char button = (mode == EXT_EDIT_LOOP) ? CMD_LOOP : CMD_METRO;
+        flashTimer = timers.schedule(FLASH_MS, [this, button]() {
+            lightOn = !lightOn;
+            midiSender->sendCc(button, lightOn ? 1 : 0);
+        }, FLASH_MS);
+    }
+    else if (mode == EXT_EDIT_FX) {
+        debugLog("RUN: EXT_EDIT_FX");
+        fxParamUpdate(ctx, midiSender, true);
+        // Flash AUTO while the knobs control FX parameters
+        flashTimer = timers.schedule(FLASH_MS, [this]() {
+            lightOn = !lightOn;
+            midiSender->sendCc(CMD_AUTO, lightOn ? 1 : 0);
+        }, FLASH_MS);
+    }
+    else if (mode == EXT_EDIT_SENDS) {
+        debugLog("RUN: EXT_EDIT_SENDS");
+        routePageUpdate(ctx, midiSender, true);
+        // Flash QUANTIZE while the knobs control sends / receives
+        flashTimer = timers.schedule(FLASH_MS, [this]() {
+            lightOn = !lightOn;
+            midiSender->sendCc(CMD_QUANTIZE, lightOn ? 1 : 0);
+        }, FLASH_MS);
+    }
+    else if (mode == EXT_EDIT_SEARCH) {
+        debugLog("RUN: EXT_EDIT_SEARCH");
+        searchPageUpdate(ctx, midiSender);
+        // Flash the selected track's M button while a name is spelled
+        flashTimer = timers.schedule(FLASH_MS, [this]() {
+            lightOn = !lightOn;
+            midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_MUTE, lightOn ? 1 : 0);
+        }, FLASH_MS);
+    }
+}
+
+void NiMidiSurface::onClickTimeout(unsigned char command) {
+    auto it = pendingClicks.find(command);
+    if (it == pendingClicks.end()) {
+        return;
+    }
+    // No second event arrived within the threshold, treat it as a single-click
+    debugLog("Single Click Event '" + std::to_string(command) + "': timed out");
+    unsigned char value = it->second.value;
+    pendingClicks.erase(it);
+    dispatchClick(command, value, EVENT_CLICK_SINGLE);
+}
+
+void NiMidiSurface::dispatchClick(unsigned char command, unsigned char value, const char* info) {
+    ctx.nextOpenTime = monotonicMs() + CLICK_COOLDOWN_MS;
+    processor->Handle(command, value, info);
+}
+
+void NiMidiSurface::onSelectionSettled() {
+    // Fallback to master track when no track is selected
+    if (trackDebouncer.shouldFallbackToMaster()) {
+        ctx.state.trackInFocus = 0; // master track
+        debugLog("[Debounce] Fallback to master track (no selection)");
+        trackDebouncer.reset(); // clean after decision
     }
 }
 
 void NiMidiSurface::SetPlayState(bool play, bool pause, bool rec) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetPlayState");
-    
-    // Update transport button lights
+    sendTransportLights(play, pause, rec);
+    if (!play && !pause && ctx.countInTriggered) {
+        disableRecCountIn(ctx); // disable count-in for recording if it had been requested earlier by keyboard
+        // Restore metronome state to last known state while COUNT IN was triggered
+        if (ctx.countInMetroState == 0) {
+            Main_OnCommand(41746, 0); // Disable the metronome
+        }
+        else {
+            Main_OnCommand(41745, 0); // Enable the metronome
+        }
+    }
+}
+
+void NiMidiSurface::sendTransportLights(bool play, bool pause, bool rec) {
     if (rec) {
         midiSender->sendCc(CMD_REC, 1);
     }
@@ -266,48 +421,49 @@ void NiMidiSurface::SetPlayState(bool play, bool pause, bool rec) {
     else {
         midiSender->sendCc(CMD_PLAY, 0);
         midiSender->sendCc(CMD_STOP, 1);
-        if (g_KKcountInTriggered) {
-            disableRecCountIn(); // disable count-in for recording if it had been requested earlier by keyboard
-            // Restore metronome state to last known state while COUNT IN was triggered
-            if (g_KKcountInMetroState == 0) {
-                Main_OnCommand(41746, 0); // Disable the metronome
-            }
-            else {
-                Main_OnCommand(41745, 0); // Enable the metronome
-            }
-        }
     }
 }
 
 void NiMidiSurface::SetRepeatState(bool rep) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetRepeatState");
     midiSender->sendCc(CMD_LOOP, rep ? 1 : 0);
 }
 
 void NiMidiSurface::SetTrackListChange() {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    ctx.routing.invalidate(); // tracks and their numbers may be gone
+    ctx.bank.invalidate(); // also reported when tracks were shown / hidden in the mixer or folders collapsed
+    ctx.trackSearch.invalidate();
+    ctx.markers.invalidate(); // also reported on project tab switches
+    ctx.items.invalidate(); // a track pointer may now be another track
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetTrackListChange");
     
     // If tracklist changes update Mixer View and ensure sanity of track and bank focus
     int numTracks = CSurf_NumTracks(false);
     // Protect against loosing track focus that could impede track navigation. Set focus on last track in this case.
-    if (g_trackInFocus > numTracks) {
-        g_trackInFocus = numTracks;
+    if (ctx.state.trackInFocus > numTracks) {
+        ctx.state.trackInFocus = numTracks;
         // Unfortunately we cannot afford to explicitly select the last track automatically because this could screw up
         // running actions or macros. The plugin must not manipulate track selection without the user deliberately triggering
         // track selection/navigation on the keyboard (or from within Reaper).
     }
     // Protect against loosing bank focus. Set focus on last bank in this case.
-    if (bankStart > numTracks) {
-        int lastInLastBank = numTracks % BANK_NUM_TRACKS;
-        bankStart = numTracks - lastInLastBank;
+    int lastPos = ctx.bank.size() - 1;
+    if (ctx.state.bankStart > lastPos) {
+        int lastInLastBank = lastPos % BANK_NUM_TRACKS;
+        ctx.state.bankStart = lastPos - lastInLastBank;
     }
     // If no track is selected at all (e.g. if previously selected track got removed), then this will now also show up in the
     // Mixer View. However, KK instance focus may still be present! This can be a little bit confusing for the user as typically
     // the track holding the focused KK instance will also be selected. This situation gets resolved as soon as any form of
     // track navigation/selection happens (from keyboard or from within Reaper).
-    allMixerUpdate(midiSender);
+    if (!ctx.mixerHidden()) { // FX / routing mode follow on the next tick, the mixer is redrawn on leaving them
+        allMixerUpdate(ctx, midiSender);
+    }
+    else if (ctx.getExtEditMode() == EXT_EDIT_SEARCH && editModeShown == EXT_EDIT_SEARCH) {
+        searchPageUpdate(ctx, midiSender); // matches may have new numbers or be gone
+    }
     // ToDo: Consider sending some updates to force NIHIA to really fully update the display. Maybe in conjunction with changes to peakMixerUpdate?
     metronomeUpdate(midiSender); // check if metronome status has changed on project tab change
 }
@@ -323,101 +479,126 @@ void NiMidiSurface::SetSurfaceSelected(MediaTrack* track, bool selected) {
         // SetSurfaceSelected() is less economical because it will be called multiple times when something changes (also for unselecting tracks, change of any record arm, change of any auto mode, change of name, ...).
         // However, SetSurfaceSelected() is the more robust choice because of: https://forum.cockos.com/showpost.php?p=2138446&postcount=15
         // A good solution for efficiency is to only evaluate messages with (selected == true).
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     int id = CSurf_TrackToID(track, false);
-    int numInBank = id % BANK_NUM_TRACKS;
     trackDebouncer.update(id, selected);
+    // Decide about the master track fallback once the selection changes settled
+    timers.cancel(debounceTimer);
+    debounceTimer = timers.schedule(g_selectionDebounceMs, [this]() { this->onSelectionSettled(); });
+
+    // Only collect here: a burst reports every track, the selected ones are evaluated once in the next Run()
+    if (selected && id >= 0) {
+        selectedDirty.push_back(id);
+    }
+    // Renaming any track reports all of them, selected or not. The search index catches up once it is shown.
+    if (id > 0) {
+        ctx.trackSearch.markStale();
+    }
+}
+
+void NiMidiSurface::processSelectedTracks() {
+    if (ctx.trackSearch.isStale() && ctx.getExtEditMode() == EXT_EDIT_SEARCH && editModeShown == EXT_EDIT_SEARCH) {
+        searchPageUpdate(ctx, midiSender); // renamed while a name is spelled
+    }
+    if (selectedDirty.empty()) return;
+    // REAPER reports in track order, the last selected track reported takes the focus
+    int focus = selectedDirty.back();
+    std::sort(selectedDirty.begin(), selectedDirty.end());
+    selectedDirty.erase(std::unique(selectedDirty.begin(), selectedDirty.end()), selectedDirty.end());
 
     // ---------------- Track Selection and Instance Focus ----------------
-    if (selected) {
-        if (id != g_trackInFocus) {
-            // Track selection has changed
-            g_trackInFocus = id;
-            debugLog("trackInFocus updated to: " + std::to_string(g_trackInFocus));
-            
-            if (getExtEditMode() != EXT_EDIT_ON) UpdateMixerScreenEncoder(id, numInBank);
-        }
-        
-        // ------------------------- Automation Mode -----------------------
-        // Update automation mode
-        // AUTO = ON: touch, write, latch or latch preview
-        // AUTO = OFF: trim or read
-        int globalAutoMode = GetGlobalAutomationOverride();
-        if ((id > 0) && (globalAutoMode == -1)) {
-            // Check automation mode of currently focused track
-            int autoMode = *(int*)GetSetMediaTrackInfo(track, "I_AUTOMODE", nullptr);
-            midiSender->sendCc(CMD_AUTO, autoMode > 1 ? 1 : 0);
+    // The navigation handlers set trackInFocus before selecting, so other selected tracks in the burst also count as
+    // a change (the focus moved over them when every callback was evaluated on its own)
+    if (focus != ctx.state.trackInFocus || selectedDirty.size() > 1) {
+        // Track selection has changed
+        ctx.state.trackInFocus = focus;
+        debugLog("trackInFocus updated to: " + std::to_string(ctx.state.trackInFocus));
+
+        if (ctx.getExtEditMode() != EXT_EDIT_ON && !ctx.mixerHidden()) {
+            UpdateMixerScreenEncoder(focus);
         }
-        else {
-            // Global Automation Override
-            midiSender->sendCc(CMD_AUTO, globalAutoMode > 1 ? 1 : 0);
-        }
-        
-        // --------------------------- Track Names --------------------------
-        // Update selected track name
-        // Note: Rather than using a callback SetTrackTitle(MediaTrack *track, const char *title) we update the name within
-        // SetSurfaceSelected as it will be called anyway when the track name changes and SetTrackTitle sometimes receives 
-        // cascades of calls for all tracks even if only one name changed
-        if ((id > 0) && (id >= bankStart) && (id <= bankEnd) && getExtEditMode() != EXT_EDIT_ON) {
-            char* name = (char*)GetSetMediaTrackInfo(track, "P_NAME", nullptr);
-            if ((!name) || (*name == '\0')) {
-                std::string s = "TRACK " + std::to_string(id);
-                std::vector<char> nameGeneric(s.begin(), s.end()); // memory safe conversion to C style char
-                nameGeneric.push_back('\0');
-                name = &nameGeneric[0];
-            }
-            midiSender->sendSysex(CMD_TRACK_NAME, 0, numInBank, name);
+    }
+
+    // ------------------------- Automation Mode -----------------------
+    // One light for the whole keyboard: only the focused track's mode is shown (AUTO flashes in FX mode)
+    if (ctx.getExtEditMode() != EXT_EDIT_FX) {
+        updateAutoLight(CSurf_TrackFromID(focus, false), focus);
+    }
+
+    // --------------------------- Track Names --------------------------
+    // Update selected track names
+    // Note: Rather than using a callback SetTrackTitle(MediaTrack *track, const char *title) we update the name within
+    // SetSurfaceSelected as it will be called anyway when the track name changes and SetTrackTitle sometimes receives
+    // cascades of calls for all tracks even if only one name changed
+    if (ctx.getExtEditMode() != EXT_EDIT_ON && !ctx.mixerHidden()) {
+        for (int id : selectedDirty) {
+            int numInBank = ctx.slotOf(id);
+            if ((id == 0) || (numInBank < 0)) continue;
+            MediaTrack* track = CSurf_TrackFromID(id, false);
+            if (!track) continue;
+            midiSender->sendSysex(CMD_TRACK_NAME, 0, numInBank, ctx.trackNames.get(track, id));
         }
     }
+    selectedDirty.clear();
+}
+
+void NiMidiSurface::updateAutoLight(MediaTrack* track, int id) {
+    // Update automation mode
+    // AUTO = ON: touch, write, latch or latch preview
+    // AUTO = OFF: trim or read
+    int globalAutoMode = GetGlobalAutomationOverride();
+    if ((id > 0) && (globalAutoMode == -1)) {
+        // Check automation mode of currently focused track
+        int* autoMode = track ? (int*)GetSetMediaTrackInfo(track, "I_AUTOMODE", nullptr) : nullptr;
+        midiSender->sendCc(CMD_AUTO, (autoMode && *autoMode > 1) ? 1 : 0);
+    }
+    else {
+        // Global Automation Override
+        midiSender->sendCc(CMD_AUTO, globalAutoMode > 1 ? 1 : 0);
+    }
 }
 
 void NiMidiSurface::SetSurfaceVolume(MediaTrack* track, double volume) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetSurfaceVolume");
+    if (ctx.mixerHidden()) return; // the mixer is redrawn when FX / routing mode ends
     
-    int id = CSurf_TrackToID(track, false);
-    if ((id >= bankStart) && (id <= bankEnd)) {
-        int numInBank = id % BANK_NUM_TRACKS;
-        char volText[64] = { 0 };
-        mkvolstr(volText, volume);
-        midiSender->sendSysex(CMD_TRACK_VOLUME_TEXT, 0, numInBank, volText);
-        midiSender->sendCc((CMD_KNOB_VOLUME0 + numInBank), volToChar_KkMk3(volume * 1.05925));
+    int numInBank = ctx.slotOf(CSurf_TrackToID(track, false));
+    if (numInBank >= 0) {
+        sendSlotVolume(ctx, midiSender, numInBank, volume);
     }
 }
 
 void NiMidiSurface::SetSurfacePan(MediaTrack* track, double pan) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetSurfacePan");
+    if (ctx.mixerHidden()) return;
     
-    int id = CSurf_TrackToID(track, false);
-    if (id < bankStart || id > bankEnd) return;
-    int numInBank = id % BANK_NUM_TRACKS;
-    char panText[64];
-    mkpanstr(panText, pan);
-    midiSender->sendSysex(CMD_TRACK_PAN_TEXT, 0, numInBank, panText);
-    midiSender->sendCc(CMD_KNOB_PAN0 + numInBank, panToChar(pan));
+    int numInBank = ctx.slotOf(CSurf_TrackToID(track, false));
+    if (numInBank < 0) return;
+    sendSlotPan(ctx, midiSender, numInBank, pan);
 }
 
 void NiMidiSurface::SetSurfaceMute(MediaTrack* track, bool mute) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetSurfaceMute");
     
     int id = CSurf_TrackToID(track, false);
-    if (id == g_trackInFocus) {
+    if (id == ctx.state.trackInFocus) {
         midiSender->sendSysex(CMD_TOGGLE_SEL_TRACK_MUTE, mute ? 1 : 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
         midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_MUTE, mute ? 1 : 0); // Needed by NIHIA v1.8.8 (KK v2.1.3)
     }
-    if ((id >= bankStart) && (id <= bankEnd)) {
-        int numInBank = id % BANK_NUM_TRACKS;
-        if (g_muteStateBank[numInBank] != mute) { // Efficiency: only send updates if soemthing changed
-            g_muteStateBank[numInBank] = mute;
+    int numInBank = ctx.slotOf(id);
+    if ((numInBank >= 0) && !ctx.mixerHidden()) {
+        if (ctx.state.muteStateBank[numInBank] != mute) { // Efficiency: only send updates if soemthing changed
+            ctx.state.muteStateBank[numInBank] = mute;
             midiSender->sendSysex(CMD_TRACK_MUTED, mute ? 1 : 0, numInBank);
         }
     }
 }
 
 void NiMidiSurface::SetSurfaceSolo(MediaTrack* track, bool solo) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     debugLog("SetSurfaceSolo");
     
     // Note: Solo in Reaper can have different meanings (Solo In Place, Solo In Front and much more -> Reaper Preferences)
@@ -425,15 +606,15 @@ void NiMidiSurface::SetSurfaceSolo(MediaTrack* track, bool solo) {
 
     // --------- MASTER: Ignore solo on master, id = 0 is only used as an "any track is soloed" change indicator ------------
     if (id == 0) {
-        // If g_anySolo state has changed update the tracks' muted by solo states within the current bank
-        if (g_anySolo != solo) {
-            g_anySolo = solo;
-            allMixerUpdate(midiSender); // Everything needs to be updated, not good enough to just update muted_by_solo states
+        // If ctx.state.anySolo state has changed update the tracks' muted by solo states within the current bank
+        if (ctx.state.anySolo != solo) {
+            ctx.state.anySolo = solo;
+            if (!ctx.mixerHidden()) allMixerUpdate(ctx, midiSender); // Everything needs to be updated, not good enough to just update muted_by_solo states
         }
         // If any track is soloed the currently selected track will be muted by solo unless it is also soloed
-        if (g_trackInFocus > 0) {
-            if (g_anySolo) {
-                MediaTrack* track = CSurf_TrackFromID(g_trackInFocus, false);
+        if (ctx.state.trackInFocus > 0) {
+            if (ctx.state.anySolo) {
+                MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
                 if (!track) {
                     return;
                 }
@@ -450,41 +631,58 @@ void NiMidiSurface::SetSurfaceSolo(MediaTrack* track, bool solo) {
     }
 
     // ------------------------- TRACKS: Solo state has changed on individual tracks ----------------------------------------
-    if (id == g_trackInFocus) {
+    if (id == ctx.state.trackInFocus) {
         midiSender->sendSysex(CMD_TOGGLE_SEL_TRACK_SOLO, solo ? 1 : 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
         midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_SOLO, solo ? 1 : 0); // Needed by NIHIA v1.8.8 (KK v2.1.3)
     }
-    if ((id >= bankStart) && (id <= bankEnd)) {
-        int numInBank = id % BANK_NUM_TRACKS;
+    int numInBank = ctx.slotOf(id);
+    if ((numInBank >= 0) && !ctx.mixerHidden()) {
         if (solo) {
-            if (g_soloStateBank[numInBank] != 1) {
-                g_soloStateBank[numInBank] = 1;
+            if (ctx.state.soloStateBank[numInBank] != 1) {
+                ctx.state.soloStateBank[numInBank] = 1;
                 midiSender->sendSysex(CMD_TRACK_SOLOED, 1, numInBank);
                 midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, 0, numInBank);
             }
         }
         else {
-            if (g_soloStateBank[numInBank] != 0) {
-                g_soloStateBank[numInBank] = 0;
+            if (ctx.state.soloStateBank[numInBank] != 0) {
+                ctx.state.soloStateBank[numInBank] = 0;
                 midiSender->sendSysex(CMD_TRACK_SOLOED, 0, numInBank);
-                midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, g_anySolo ? 1 : 0, numInBank);
+                midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, ctx.state.anySolo ? 1 : 0, numInBank);
             }
         }
     }
 }
 
 void NiMidiSurface::SetSurfaceRecArm(MediaTrack* track, bool armed) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return;
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return;
     // Note: record arm also leads to a cascade of other callbacks (-> filtering required!)
     int id = CSurf_TrackToID(track, false);
-    if ((id >= bankStart) && (id <= bankEnd)) {
-        int numInBank = id % BANK_NUM_TRACKS;
+    int numInBank = ctx.slotOf(id);
+    if ((numInBank >= 0) && !ctx.mixerHidden()) {
         midiSender->sendSysex(CMD_TRACK_ARMED, armed ? 1 : 0, numInBank);
     }
 }
 
 int NiMidiSurface::Extended(int call, void* parm1, void* parm2, void* parm3) {
-    if (g_connectedState != KK_NIHIA_CONNECTED) return 0;
+    if (call == CSURF_EXT_RESET) {
+        ctx.routing.invalidate();
+        ctx.markers.invalidate();
+        ctx.items.invalidate();
+    }
+    if (call == CSURF_EXT_SETPROJECTMARKERCHANGE) {
+        ctx.markers.invalidate(); // read again on the next marker navigation
+        return 0;
+    }
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) return 0;
+    if (call == CSURF_EXT_SETSENDVOLUME || call == CSURF_EXT_SETSENDPAN || call == CSURF_EXT_SETRECVVOLUME ||
+        call == CSURF_EXT_SETRECVPAN) {
+        // A route changed from the mixer or automation: show it right away instead of on the next tick
+        if (ctx.getExtEditMode() == EXT_EDIT_SENDS && editModeShown == EXT_EDIT_SENDS) {
+            routePageUpdate(ctx, midiSender);
+        }
+        return 0;
+    }
     if (call != CSURF_EXT_SETMETRONOME) {
         return 0; // we are only interested in the metronome. Note: This works fine but does not update the status when changing project tabs
     }
@@ -493,80 +691,93 @@ int NiMidiSurface::Extended(int call, void* parm1, void* parm2, void* parm3) {
 }
 
 void NiMidiSurface::_onMidiEvent(MIDI_event_t* event) {
-    if (event->midi_message[0] != MIDI_CC) return;
+    // Only complete CC messages carry a command and a value, anything else from the port is ignored
+    if (event->size < 3 || event->midi_message[0] != MIDI_CC) return;
 
     unsigned char& command = event->midi_message[1];
     unsigned char& value = event->midi_message[2];
 
     // Handshake
     if (command == CMD_HELLO) {
-        protocolVersion = value;
-        if (value > 0) {
+        ctx.protocolVersion = value;
+        // Late answers to a repeated HELLO must not trigger another resync
+        if (value > 0 && ctx.connectedState == KK_MIDI_FOUND) {
             debugLog("CMD_HELLO");
-            // Turn on button lights
-            midiSender->sendCc(CMD_UNDO, 1);
-            midiSender->sendCc(CMD_REDO, 1);
-            midiSender->sendCc(CMD_CLEAR, 1);
-            midiSender->sendCc(CMD_QUANTIZE, 1);
-            allMixerUpdate(midiSender);
-            g_connectedState = KK_NIHIA_CONNECTED;
+            timers.cancel(connectTimer);
+            scanInterval = SCAN_MS;
+            failureReported = false;
+            ctx.connectedState = KK_NIHIA_CONNECTED;
+            resync();
+            livenessTimer = timers.schedule(LIVENESS_MS, [this]() { this->checkLiveness(); }, LIVENESS_MS);
         }
 
         return;
     }
-    else if (doubleClickCommands.find(command) != doubleClickCommands.end()) {
+    if (ctx.connectedState != KK_NIHIA_CONNECTED) {
+        return; // no input before the handshake completed
+    }
+    if (doubleClickCommands.find(command) != doubleClickCommands.end()) {
         addEventToMap(command, value);
         return;
     }
 
-    static CommandProcessor processor(*midiSender);
-    processor.Handle(command, value, EVENT_CLICK_SINGLE);
+    processor->Handle(command, value, EVENT_CLICK_SINGLE);
 }
 
 void NiMidiSurface::addEventToMap(unsigned char command, unsigned char value) {
-    // Check if the command already has 2 events stored in the map & if still during cooldown to prevent multiple clicks
-    if (eventMap[command].size() >= 2 || (nextOpenTimer > timer)) {
-        debugLog("Max events reached for command: " + std::to_string(command));
+    // Ignore clicks during the cooldown after the last click gesture to prevent multiple clicks
+    if (ctx.nextOpenTime > monotonicMs()) {
+        debugLog("Click during cooldown ignored for command: " + std::to_string(command));
         return;
     }
 
-    MidiEventData eventData = { value, timer };
-    eventMap[command].push_back(eventData);
+    auto it = pendingClicks.find(command);
+    if (it != pendingClicks.end()) {
+        // Second event within the threshold: treat it as a double-click, using the last event's value
+        debugLog("Double Click Event '" + std::to_string(command) + "'");
+        timers.cancel(it->second.timeout);
+        pendingClicks.erase(it);
+        dispatchClick(command, value, EVENT_CLICK_DOUBLE);
+        return;
+    }
+
+    PendingClick click;
+    click.value = value;
+    click.timeout = timers.schedule(DOUBLE_CLICK_MS, [this, command]() { this->onClickTimeout(command); });
+    pendingClicks[command] = click;
 }
 
-void NiMidiSurface::UpdateMixerScreenEncoder(int id, int numInBank)
+void NiMidiSurface::UpdateMixerScreenEncoder(int id)
 {
     debugLog("UpdateMixerScreenEncoder");
     
-    int oldBankStart = bankStart;
-    bankStart = id - numInBank;
-    if (bankStart != oldBankStart) {
+    // Bank holding the track, for a track filtered out of the bank layout the one holding the next track
+    int pos = std::min(ctx.bank.rankOf(id), ctx.bank.size() - 1);
+    int oldBankStart = ctx.state.bankStart;
+    ctx.state.bankStart = pos - pos % BANK_NUM_TRACKS;
+    if (ctx.state.bankStart != oldBankStart) {
         // Update everything
-        allMixerUpdate(midiSender); // Note: this will also update 4D track nav LEDs, g_muteStateBank and g_soloStateBank caches
+        allMixerUpdate(ctx, midiSender); // Note: this will also update 4D track nav LEDs, ctx.state.muteStateBank and ctx.state.soloStateBank caches
     }
     else {
         // Update 4D Encoder track navigation LEDs
-        int numTracks = CSurf_NumTracks(false);
-        int trackNavLights = 3; // left and right on
-        if (g_trackInFocus < 2) {
-            trackNavLights &= 2; // left off
-        }
-        if (g_trackInFocus >= numTracks) {
-            trackNavLights &= 1; // right off
-        }
-        midiSender->sendCc(CMD_NAV_TRACKS, trackNavLights);
+        midiSender->sendCc(CMD_NAV_TRACKS, trackNavLights(ctx));
+    }
+    int numInBank = ctx.slotOf(id);
+    if (numInBank < 0) {
+        return; // not on the display
     }
-    if (g_trackInFocus != 0) {
+    if (ctx.state.trackInFocus != 0) {
         // Mark selected track as available and update Mute and Solo Button lights
         midiSender->sendSysex(CMD_SEL_TRACK_AVAILABLE, 1, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
         midiSender->sendCc(CMD_SEL_TRACK_AVAILABLE, 1); // Needed by NIHIA v1.8.8 (KK v2.1.3)
-        midiSender->sendSysex(CMD_TOGGLE_SEL_TRACK_MUTE, g_muteStateBank[numInBank] ? 1 : 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
-        midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_MUTE, g_muteStateBank[numInBank] ? 1 : 0); // Needed by NIHIA v1.8.8 (KK v2.1.3)
-        midiSender->sendSysex(CMD_TOGGLE_SEL_TRACK_SOLO, g_soloStateBank[numInBank], 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
-        midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_SOLO, g_soloStateBank[numInBank]); // Needed by NIHIA v1.8.8 (KK v2.1.3)
-        if (g_anySolo) {
-            midiSender->sendSysex(CMD_SEL_TRACK_MUTED_BY_SOLO, (g_soloStateBank[numInBank] == 0) ? 1 : 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
-            midiSender->sendCc(CMD_SEL_TRACK_MUTED_BY_SOLO, (g_soloStateBank[numInBank] == 0) ? 1 : 0); // Needed by NIHIA v1.8.8 (KK v2.1.3)
+        midiSender->sendSysex(CMD_TOGGLE_SEL_TRACK_MUTE, ctx.state.muteStateBank[numInBank] ? 1 : 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
+        midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_MUTE, ctx.state.muteStateBank[numInBank] ? 1 : 0); // Needed by NIHIA v1.8.8 (KK v2.1.3)
+        midiSender->sendSysex(CMD_TOGGLE_SEL_TRACK_SOLO, ctx.state.soloStateBank[numInBank], 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
+        midiSender->sendCc(CMD_TOGGLE_SEL_TRACK_SOLO, ctx.state.soloStateBank[numInBank]); // Needed by NIHIA v1.8.8 (KK v2.1.3)
+        if (ctx.state.anySolo) {
+            midiSender->sendSysex(CMD_SEL_TRACK_MUTED_BY_SOLO, (ctx.state.soloStateBank[numInBank] == 0) ? 1 : 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
+            midiSender->sendCc(CMD_SEL_TRACK_MUTED_BY_SOLO, (ctx.state.soloStateBank[numInBank] == 0) ? 1 : 0); // Needed by NIHIA v1.8.8 (KK v2.1.3)
         }
         else {
             midiSender->sendSysex(CMD_SEL_TRACK_MUTED_BY_SOLO, 0, 0); // Needed by NIHIA v1.8.7 (KK v2.1.2)
@@ -599,55 +810,44 @@ void NiMidiSurface::updateTransportAndNavButtons() {
     else {
         midiSender->sendCc(CMD_LOOP, 0);
     }
-    int numTracks = CSurf_NumTracks(false);
-    int trackNavLights = 3; // left and right on
-    if (g_trackInFocus < 2) {
-        trackNavLights &= 2; // left off
-    }
-    if (g_trackInFocus >= numTracks) {
-        trackNavLights &= 1; // right off
-    }
-    midiSender->sendCc(CMD_NAV_TRACKS, trackNavLights);
-    midiSender->sendCc(CMD_NAV_CLIPS, 0); // ToDo: also restore  these lights to correct values
+    midiSender->sendCc(CMD_NAV_TRACKS, trackNavLights(ctx));
+    ctx.clipLightsShown = clipNavLights(ctx);
+    midiSender->sendCc(CMD_NAV_CLIPS, static_cast<unsigned char>(ctx.clipLightsShown));
 }
 
-void NiMidiSurface::cycleEncoderLEDs(int& cycleTimer, int& cyclePos, CycleDirection direction, MidiSender* midiSender)
+void NiMidiSurface::cycleEncoderLEDs(CycleDirection direction)
 {
     debugLog("cycleEncoderLEDs");
-    cycleTimer += 1;
-    if (cycleTimer >= CYCLE_T) {
-        cycleTimer = 0;
-        cyclePos = (cyclePos + 1) % 4;
-
-        switch (cyclePos) {
-        case 0:
-            midiSender->sendCc(CMD_NAV_TRACKS, 1);
-            midiSender->sendCc(CMD_NAV_CLIPS, 0);
-            break;
-        case 1:
-            if (direction == CLOCKWISE) {
-                midiSender->sendCc(CMD_NAV_TRACKS, 0);
-                midiSender->sendCc(CMD_NAV_CLIPS, 1);
-            }
-            else {
-                midiSender->sendCc(CMD_NAV_TRACKS, 0);
-                midiSender->sendCc(CMD_NAV_CLIPS, 2);
-            }
-            break;
-        case 2:
-            midiSender->sendCc(CMD_NAV_TRACKS, 2);
-            midiSender->sendCc(CMD_NAV_CLIPS, 0);
-            break;
-        case 3:
-            if (direction == CLOCKWISE) {
-                midiSender->sendCc(CMD_NAV_TRACKS, 0);
-                midiSender->sendCc(CMD_NAV_CLIPS, 2);
-            }
-            else {
-                midiSender->sendCc(CMD_NAV_TRACKS, 0);
-                midiSender->sendCc(CMD_NAV_CLIPS, 1);
-            }
-            break;
+    cyclePos = (cyclePos + 1) % 4;
+
+    switch (cyclePos) {
+    case 0:
+        midiSender->sendCc(CMD_NAV_TRACKS, 1);
+        midiSender->sendCc(CMD_NAV_CLIPS, 0);
+        break;
+    case 1:
+        if (direction == CLOCKWISE) {
+            midiSender->sendCc(CMD_NAV_TRACKS, 0);
+            midiSender->sendCc(CMD_NAV_CLIPS, 1);
+        }
+        else {
+            midiSender->sendCc(CMD_NAV_TRACKS, 0);
+            midiSender->sendCc(CMD_NAV_CLIPS, 2);
+        }
+        break;
+    case 2:
+        midiSender->sendCc(CMD_NAV_TRACKS, 2);
+        midiSender->sendCc(CMD_NAV_CLIPS, 0);
+        break;
+    case 3:
+        if (direction == CLOCKWISE) {
+            midiSender->sendCc(CMD_NAV_TRACKS, 0);
+            midiSender->sendCc(CMD_NAV_CLIPS, 2);
+        }
+        else {
+            midiSender->sendCc(CMD_NAV_TRACKS, 0);
+            midiSender->sendCc(CMD_NAV_CLIPS, 1);
         }
+        break;
     }
 }
@@ -3,7 +3,13 @@
 #ifndef NIMIDISURFACE_H
 #define NIMIDISURFACE_H
 
+#include <unordered_map>
+#include <random>
+#include <vector>
 #include "TrackSelectionDebouncer.h"
+#include "TimerWheel.h"
+#include "MidiDeviceCache.h"
+#include "SurfaceContext.h"
 #include "reaKontrol.h"
 #include "MidiSender.h"
 
@@ -13,10 +19,13 @@ enum CycleDirection;
 
 class NiMidiSurface : public BaseSurface {
 public:
-    NiMidiSurface();
+    explicit NiMidiSurface(unsigned char surfaceIndex = 0);
     virtual ~NiMidiSurface();
 
     MidiSender* GetMidiSender();
+    SurfaceContext& GetContext() { return ctx; }
+    // Resets the scan backoff and tries to connect right away (no-op when connected)
+    void Reconnect();
 
     virtual const char* GetTypeString() override;
     virtual const char* GetDescString() override;
@@ -36,14 +45,52 @@ protected:
     void _onMidiEvent(MIDI_event_t* event) override;
 
 private:
+    SurfaceContext ctx;
     MidiSender* midiSender;
     CommandProcessor* processor;
     TrackSelectionDebouncer trackDebouncer;
+
+    // All timed behaviour runs on the timer wheel, advanced at the start of every Run()
+    struct PendingClick {
+        unsigned char value;
+        TimerWheel::TimerId timeout;
+    };
+    TimerWheel timers;
+    TimerWheel::TimerId connectTimer = TimerWheel::NO_TIMER;
+    TimerWheel::TimerId flashTimer = TimerWheel::NO_TIMER;
+    TimerWheel::TimerId cycleTimer = TimerWheel::NO_TIMER;
+    TimerWheel::TimerId actionTimer = TimerWheel::NO_TIMER;
+    TimerWheel::TimerId debounceTimer = TimerWheel::NO_TIMER;
+    TimerWheel::TimerId livenessTimer = TimerWheel::NO_TIMER;
+    std::unordered_map<unsigned char, PendingClick> pendingClicks; // first click waiting for a second one
+    std::vector<int> selectedDirty; // selected tracks reported by SetSurfaceSelected() since the last Run()
+    int editModeShown = 0; // EXT_EDIT_OFF
+    bool lightOn = false;
+    int cyclePos = 0;
+    unsigned int scanInterval = 0; // next backoff interval while not connected
+    bool failureReported = false; // handshake failure reported since the last successful connection
+    std::minstd_rand backoffRng;
+    MidiDeviceCache devices;
+    KkMidiDevices openDevices; // ports of the current connection
+
+    void scheduleConnectAttempt(unsigned int delayMs);
+    unsigned int nextScanDelay();
+    void onConnectTimer();
+    void closeMidiPorts();
+    void checkLiveness();
+    void disconnect();
+    void resync();
+    void sendTransportLights(bool play, bool pause, bool rec);
+    void updateAutoLight(MediaTrack* track, int id);
+    void enterEditMode(int mode);
+    void onClickTimeout(unsigned char command);
+    void dispatchClick(unsigned char command, unsigned char value, const char* info);
+    void onSelectionSettled();
+    void processSelectedTracks();
     void addEventToMap(unsigned char command, unsigned char value);
-    void processClickEvent();
-    void UpdateMixerScreenEncoder(int id, int numInBank);
+    void UpdateMixerScreenEncoder(int id);
     void updateTransportAndNavButtons();
-    void cycleEncoderLEDs(int& cycleTimer, int& cyclePos, CycleDirection direction, MidiSender* midiSender);
+    void cycleEncoderLEDs(CycleDirection direction);
 };
 
 #endif // NIMIDISURFACE_H
\ No newline at end of file
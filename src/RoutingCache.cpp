@@ -0,0 +1,31 @@
+#include "RoutingCache.h"
+#include "reaKontrol.h"
+
+const std::vector<Route>& RoutingCache::routes(MediaTrack* track, int category) {
+    if (!track || (category != ROUTE_SENDS && category != ROUTE_RECEIVES)) return none;
+    Entry& entry = entries[track];
+    bool& read = (category == ROUTE_SENDS) ? entry.sendsRead : entry.receivesRead;
+    std::vector<Route>& list = (category == ROUTE_SENDS) ? entry.sends : entry.receives;
+
+    int count = GetTrackNumSends(track, category);
+    if (count < 0) count = 0;
+    if (read && static_cast<int>(list.size()) == count) return list;
+
+    list.clear();
+    list.reserve(count);
+    const char* otherParm = (category == ROUTE_SENDS) ? "P_DESTTRACK" : "P_SRCTRACK";
+    for (int i = 0; i < count; ++i) {
+        Route route;
+        route.other = static_cast<MediaTrack*>(GetSetTrackSendInfo(track, category, i, otherParm, nullptr));
+        route.otherId = route.other ? CSurf_TrackToID(route.other, false) : 0;
+        list.push_back(route);
+    }
+    read = true;
+    ++rebuilds;
+    return list;
+}
+
+void RoutingCache::invalidate() {
+    entries.clear();
+    ++generations;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+class MediaTrack;
+
+constexpr int ROUTE_SENDS = 0; // GetTrackNumSends() categories
+constexpr int ROUTE_RECEIVES = -1;
+
+// One send or receive of a track: the track at the other end and its number
+struct Route {
+    MediaTrack* other = nullptr;
+    int otherId = 0;
+};
+
+// Routing graph of the project: sends and receives per track, in REAPER's route order. A track's routes are only read
+// when they are shown and then kept until invalidate() (track list changed: pointers and numbers may be stale). If
+// REAPER reports a different number of routes than cached, e.g. a send was added, that track's list is read again.
+class RoutingCache {
+public:
+    const std::vector<Route>& routes(MediaTrack* track, int category);
+    void invalidate();
+    // Changes with every invalidate(), so route lists from before are not compared with new ones
+    unsigned int generation() const { return generations; }
+    // Number of route lists read since construction, for diagnostics
+    unsigned int rebuildCount() const { return rebuilds; }
+
+private:
+    struct Entry {
+        bool sendsRead = false;
+        bool receivesRead = false;
+        std::vector<Route> sends;
+        std::vector<Route> receives;
+    };
+
+    std::unordered_map<MediaTrack*, Entry> entries;
+    std::vector<Route> none;
+    unsigned int generations = 0;
+    unsigned int rebuilds = 0;
+};
@@ -0,0 +1,51 @@
+#include "SurfaceContext.h"
+#include <atomic>
+#include <sstream>
+#include "Utils.h"
+#include "ActionList.h"
+
+void SurfaceContext::setExtEditMode(int newMode) {
+    if (extEditMode != newMode) {
+        std::ostringstream msg;
+        msg << "[ExtEditMode] '" << getConstantName(extEditMode) << "' -> '" << getConstantName(newMode) << "'\n";
+        debugLog(msg);
+        extEditMode = newMode;
+    }
+
+    if (newMode == EXT_EDIT_OFF) {
+        // Back in normal mode: pick up changes to the config file (cheap if there are none)
+        loadConfigFile();
+    }
+}
+
+int SurfaceContext::slotOf(int id) {
+    int pos = bank.positionOf(id);
+    return (pos >= 0 && pos >= state.bankStart && pos <= state.bankEnd) ? pos - state.bankStart : -1;
+}
+
+static_assert(sizeof(SurfaceState) == 64, "SurfaceState is meant to fill exactly one cache line");
+
+bool SurfaceState::operator==(const SurfaceState& other) const {
+    if (bankStart != other.bankStart || bankEnd != other.bankEnd || trackInFocus != other.trackInFocus ||
+        anySolo != other.anySolo) {
+        return false;
+    }
+    for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+        if (muteStateBank[i] != other.muteStateBank[i] || soloStateBank[i] != other.soloStateBank[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SurfaceContext::publish() {
+    // Only the main thread stores, so reading our own pointer needs no atomic load
+    if (published && *published == state) {
+        return;
+    }
+    std::atomic_store(&published, std::shared_ptr<const SurfaceState>(std::make_shared<SurfaceState>(state)));
+}
+
+std::shared_ptr<const SurfaceState> SurfaceContext::snapshot() const {
+    return std::atomic_load(&published);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Constants.h"
+#include "TrackNameCache.h"
+#include "BankLayout.h"
+#include "FxParamCache.h"
+#include "RoutingCache.h"
+#include "TrackSearchIndex.h"
+#include "MarkerIndex.h"
+#include "ItemIndex.h"
+
+// Bank and meter state: read on every tick by peakMixerUpdate and on every gesture by the command handlers. Kept
+// together on one cache line, apart from the rarely touched connection and config state in SurfaceContext.
+struct alignas(64) SurfaceState {
+    int bankStart = 0; // first and last position of the shown bank in SurfaceContext::bank
+    int bankEnd = 0;
+    int trackInFocus = 0;
+    bool anySolo = false;
+    bool muteStateBank[BANK_NUM_TRACKS] = { false };
+    int soloStateBank[BANK_NUM_TRACKS] = { 0 };
+
+    bool operator==(const SurfaceState& other) const;
+    bool operator!=(const SurfaceState& other) const { return !(*this == other); }
+};
+
+// Volume and pan of one display slot as last sent. The texts only depend on the value rounded to what they show
+// (0.01 dB, 1 % pan), so while the rounded value stays the same neither mkvolstr / mkpanstr nor a message is needed.
+struct SlotValueCache {
+    static constexpr int NO_KEY = INT_MIN;
+    int volKey = NO_KEY;
+    int panKey = NO_KEY;
+    int volKnob = -1; // last knob CC value, -1: unknown
+    int panKnob = -1;
+    char volText[64] = { 0 };
+    char panText[64] = { 0 };
+};
+
+// State of one keyboard's surface. Every NiMidiSurface owns one context; the command processor and the display
+// update helpers work on the context they are given, so several keyboards run side by side, each with its own bank
+// and focus. Only REAPER's main thread writes a context.
+struct SurfaceContext {
+    SurfaceState state;
+
+    // ---- Cold: connection, count-in, mode and caches ----
+    int connectedState = KK_NOT_CONNECTED;
+    int protocolVersion = 0;
+    int connectCount = 0;
+    bool countInTriggered = false;
+    int countInMetroState = 0;
+    uint64_t nextOpenTime = 0; // End of the cooldown for processing next click events (monotonicMs)
+    int actionPage = 0; // Page of the action list shown in EXT_EDIT_ON
+    int positionSlot = -1; // Slot showing the marker / item jumped to instead of its volume / pan text, -1: none
+    uint64_t positionUntil = 0; // (monotonicMs)
+    int clipLightsShown = -1; // CMD_NAV_CLIPS value last sent for EXT_EDIT_OFF, the other modes animate these lights
+    TrackNameCache trackNames;
+    BankLayout bank;
+    SlotValueCache slots[BANK_NUM_TRACKS];
+
+    // FX parameter mode (EXT_EDIT_FX): FX of the focused track and page of its parameters on the volume knobs
+    int fxIndex = 0;
+    int fxPage = 0;
+    FxParamCache fxParams;
+    FxSlotCache fxSlots[BANK_NUM_TRACKS];
+    struct FxView {
+        MediaTrack* track = nullptr;
+        const FxParamCache::Fx* fx = nullptr;
+        unsigned int generation = 0;
+        int page = -1;
+        int numParams = -1;
+    } fxShown; // what the display shows, a difference means the whole page is drawn again
+
+    // Routing mode (EXT_EDIT_SENDS): sends or receives of the focused track, volume and pan on the knobs
+    int routeCategory = ROUTE_SENDS;
+    int routePage = 0;
+    RoutingCache routing;
+    signed char routeMuted[BANK_NUM_TRACKS] = { 0 }; // -1: not sent yet
+    struct RouteView {
+        MediaTrack* track = nullptr;
+        int category = ROUTE_SENDS;
+        unsigned int generation = 0;
+        int page = -1;
+        int count = -1;
+    } routesShown;
+
+    // Jump to track mode (EXT_EDIT_SEARCH): query spelled with the 4D encoder and the tracks matching it
+    std::string searchQuery;
+    int searchPage = 0;
+    std::vector<int> searchResults;
+    TrackSearchIndex trackSearch;
+
+    // Items of the focused track and markers / region starts the 4D encoder's up/down steps through
+    ItemIndex items;
+    MarkerIndex markers;
+
+    // Slot of track number id in the shown bank, -1 if the track isn't shown there
+    int slotOf(int id);
+
+    int getExtEditMode() const { return extEditMode; }
+    // FX, routing and search mode draw their own page instead of the mixer bank
+    bool mixerHidden() const {
+        return extEditMode == EXT_EDIT_FX || extEditMode == EXT_EDIT_SENDS || extEditMode == EXT_EDIT_SEARCH;
+    }
+    void setExtEditMode(int newMode);
+
+    // Copy-on-write view of state for other threads (e.g. output or metering): publish() runs on the main thread at
+    // the end of every tick and swaps in a new copy only if state changed since the last one. A snapshot is never
+    // modified, so readers may hold it as long as they like without locking anything.
+    void publish();
+    std::shared_ptr<const SurfaceState> snapshot() const;
+
+private:
+    int extEditMode = EXT_EDIT_OFF;
+    std::shared_ptr<const SurfaceState> published;
+};
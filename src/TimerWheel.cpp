@@ -0,0 +1,157 @@
+#include "TimerWheel.h"
+#include <chrono>
+
+static uint64_t (*g_clock)() = nullptr;
+
+uint64_t monotonicMs() {
+    if (g_clock) {
+        return g_clock();
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t monotonicUs() {
+    if (g_clock) {
+        return g_clock() * 1000;
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void setMonotonicClock(uint64_t (*clock)()) {
+    g_clock = clock;
+}
+
+TimerWheel::TimerWheel(unsigned int resolutionMs, size_t numSlots)
+    : resolution(resolutionMs ? resolutionMs : 1), slots(numSlots ? numSlots : 1) {
+}
+
+TimerWheel::TimerId TimerWheel::schedule(unsigned int delayMs, Callback callback, unsigned int periodMs) {
+    if (!started) {
+        start(monotonicMs());
+    }
+    if (nextId == NO_TIMER) {
+        ++nextId; // wrapped around
+    }
+    Timer timer = { nextId++, now + delayMs, periodMs, std::move(callback) };
+    TimerId id = timer.id;
+    insert(std::move(timer));
+    return id;
+}
+
+void TimerWheel::cancel(TimerId& id) {
+    if (id == NO_TIMER) {
+        return;
+    }
+    if (id == firing) {
+        firingCancelled = true; // cancelled from its own callback: don't reschedule
+    }
+    auto it = slotOf.find(id);
+    if (it != slotOf.end()) {
+        Timer timer;
+        take(id, it->second, timer);
+    }
+    id = NO_TIMER;
+}
+
+bool TimerWheel::pending(TimerId id) const {
+    return id != NO_TIMER && (slotOf.count(id) != 0 || (id == firing && !firingCancelled));
+}
+
+void TimerWheel::advance(uint64_t nowMs) {
+    if (!started) {
+        start(nowMs);
+    }
+    if (nowMs < now) {
+        return; // the clock is monotonic, this only happens if it got replaced
+    }
+    now = nowMs;
+    uint64_t tick = nowMs / resolution;
+    if (slotOf.empty() || tick == lastTick) {
+        lastTick = tick;
+        return;
+    }
+
+    // Visit every slot passed since the last call (each slot at most once after a long pause)
+    uint64_t steps = tick - lastTick;
+    if (steps > slots.size()) {
+        steps = slots.size();
+    }
+    due.clear();
+    for (uint64_t i = 1; i <= steps; ++i) {
+        for (const Timer& timer : slots[(lastTick + i) % slots.size()]) {
+            if (timer.deadline <= now) {
+                due.push_back(timer.id);
+            }
+        }
+    }
+    // Timers scheduled from the callbacks below go into slots after the current position
+    lastTick = tick;
+
+    for (size_t i = 0; i < due.size(); ++i) {
+        auto it = slotOf.find(due[i]);
+        if (it == slotOf.end()) {
+            continue; // cancelled by an earlier callback
+        }
+        Timer timer;
+        take(due[i], it->second, timer);
+        firing = timer.id;
+        firingCancelled = false;
+        timer.callback();
+        firing = NO_TIMER;
+        if (timer.period && !firingCancelled) {
+            timer.deadline += timer.period;
+            if (timer.deadline <= now) {
+                timer.deadline = now + timer.period; // fell behind (e.g. REAPER was blocked): skip, don't burst
+            }
+            insert(std::move(timer));
+        }
+    }
+}
+
+void TimerWheel::clear() {
+    for (std::vector<Timer>& slot : slots) {
+        slot.clear();
+    }
+    slotOf.clear();
+    firingCancelled = true;
+}
+
+void TimerWheel::start(uint64_t t) {
+    started = true;
+    now = t;
+    lastTick = t / resolution;
+}
+
+size_t TimerWheel::slotFor(uint64_t deadline) const {
+    // Round up, so the timer is due whenever its slot is visited in the right round. Never hash into a slot that was
+    // already visited for the current position.
+    uint64_t tick = (deadline + resolution - 1) / resolution;
+    if (tick <= lastTick) {
+        tick = lastTick + 1;
+    }
+    return static_cast<size_t>(tick % slots.size());
+}
+
+void TimerWheel::insert(Timer&& timer) {
+    size_t slot = slotFor(timer.deadline);
+    slotOf[timer.id] = slot;
+    slots[slot].push_back(std::move(timer));
+}
+
+bool TimerWheel::take(TimerId id, size_t slot, Timer& timer) {
+    std::vector<Timer>& list = slots[slot];
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (list[i].id == id) {
+            timer = std::move(list[i]);
+            if (i + 1 != list.size()) {
+                list[i] = std::move(list.back());
+            }
+            list.pop_back();
+            slotOf.erase(id);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Milliseconds on a monotonic clock (std::chrono::steady_clock unless replaced, see setMonotonicClock)
+uint64_t monotonicMs();
+// Same clock in microseconds (full resolution only with steady_clock)
+uint64_t monotonicUs();
+
+// Replaces the clock behind monotonicMs(), e.g. by a virtual clock advanced by a mock host. nullptr restores steady_clock.
+void setMonotonicClock(uint64_t (*clock)());
+
+// Hashed timer wheel: timers are hashed by their deadline into a fixed number of slots of resolutionMs each. advance()
+// only visits the slots whose time has come since the last call, so an idle tick is O(1) and firing a timer costs
+// O(timers in its slot). Callbacks run from advance(), i.e. from Run() on REAPER's main thread, and may schedule or
+// cancel timers themselves.
+class TimerWheel {
+public:
+    using TimerId = unsigned int;
+    using Callback = std::function<void()>;
+    static constexpr TimerId NO_TIMER = 0;
+
+    explicit TimerWheel(unsigned int resolutionMs = 10, size_t numSlots = 64);
+
+    // One-shot timer firing after delayMs, or a periodic timer when periodMs > 0 (first firing after delayMs)
+    TimerId schedule(unsigned int delayMs, Callback callback, unsigned int periodMs = 0);
+    // Cancels the timer (if still pending) and resets id to NO_TIMER
+    void cancel(TimerId& id);
+    bool pending(TimerId id) const;
+
+    // Fires all timers due at nowMs
+    void advance(uint64_t nowMs);
+    void advance() { advance(monotonicMs()); }
+
+    size_t size() const { return slotOf.size(); }
+    void clear();
+
+private:
+    struct Timer {
+        TimerId id;
+        uint64_t deadline;
+        unsigned int period;
+        Callback callback;
+    };
+
+    void start(uint64_t t);
+    size_t slotFor(uint64_t deadline) const;
+    void insert(Timer&& timer);
+    bool take(TimerId id, size_t slot, Timer& timer);
+
+    unsigned int resolution;
+    std::vector<std::vector<Timer>> slots;
+    std::unordered_map<TimerId, size_t> slotOf; // pending timers by id
+    std::vector<TimerId> due; // scratch list for advance()
+    uint64_t now = 0;
+    uint64_t lastTick = 0; // wheel position, in units of resolution
+    bool started = false;
+    TimerId nextId = 1;
+    TimerId firing = NO_TIMER; // timer whose callback is running
+    bool firingCancelled = false;
+};
@@ -0,0 +1,116 @@
+#include "TrackNameCache.h"
+#include "Constants.h"
+#include "reaKontrol.h"
+
+namespace {
+    // Entries of deleted tracks are never looked up again, start over once this many piled up
+    constexpr size_t MAX_ENTRIES = 4096;
+
+    // U+00C0 .. U+00FF
+    const char* const LATIN1_LETTERS[64] = {
+        "A", "A", "A", "A", "A", "A", "AE", "C", "E", "E", "E", "E", "I", "I", "I", "I",
+        "D", "N", "O", "O", "O", "O", "O", "x", "O", "U", "U", "U", "U", "Y", "TH", "ss",
+        "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+        "d", "n", "o", "o", "o", "o", "o", "/", "o", "u", "u", "u", "u", "y", "th", "y"
+    };
+    // U+0100 .. U+017F (Latin Extended-A), base letter of each character
+    const char LATIN_EXT_A[] =
+        "AaAaAaCcCcCcCcDdDdEeEeEeEeEeGgGgGgGgHhHhIiIiIiIiIiIiJjKkkLlLlLlLlLlNnNnNnnNnOoOoOoOoRrRrRrSsSsSsSsTtTtTt"
+        "UuUuUuUuUuUuWwYyYZzZzZzs";
+    static_assert(sizeof(LATIN_EXT_A) == 128 + 1, "one letter per code point");
+
+    // ASCII replacement for code point cp, nullptr to drop it
+    const char* transliterate(uint32_t cp, char (&single)[2]) {
+        single[1] = '\0';
+        if (cp < 0x20 || cp == 0x7F) return nullptr;
+        if (cp < 0x80) {
+            single[0] = static_cast<char>(cp);
+            return single;
+        }
+        if (cp >= 0xC0 && cp <= 0xFF) return LATIN1_LETTERS[cp - 0xC0];
+        if (cp >= 0x100 && cp <= 0x17F) {
+            single[0] = LATIN_EXT_A[cp - 0x100];
+            return single;
+        }
+        switch (cp) {
+        case 0xA0: return " "; // no-break space
+        case 0xAB: return "<<";
+        case 0xBB: return ">>";
+        case 0xB7: return ".";
+        case 0x2010: case 0x2011: case 0x2012: case 0x2013: case 0x2014: case 0x2212: return "-";
+        case 0x2018: case 0x2019: case 0x201A: case 0x2032: return "'";
+        case 0x201C: case 0x201D: case 0x201E: case 0x2033: return "\"";
+        case 0x2026: return "...";
+        case 0x266D: return "b"; // flat
+        case 0x266F: return "#"; // sharp
+        default: return (cp < 0xA0) ? nullptr : "?"; // C1 controls are dropped
+        }
+    }
+
+    // Decodes the code point at p, returns the number of bytes used (at least 1). Invalid sequences yield U+FFFD.
+    size_t decodeUtf8(const unsigned char* p, uint32_t& cp) {
+        unsigned char c = p[0];
+        size_t len;
+        if (c < 0x80) {
+            cp = c;
+            return 1;
+        }
+        else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; len = 2; }
+        else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; len = 3; }
+        else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; len = 4; }
+        else {
+            cp = 0xFFFD;
+            return 1;
+        }
+        for (size_t i = 1; i < len; ++i) {
+            if ((p[i] & 0xC0) != 0x80) { // also stops at the terminator
+                cp = 0xFFFD;
+                return i;
+            }
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        return len;
+    }
+}
+
+std::string toDisplayName(const char* utf8, size_t maxChars) {
+    std::string out;
+    if (!utf8) return out;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(utf8);
+    char single[2];
+    while (*p && out.size() < maxChars) {
+        uint32_t cp;
+        p += decodeUtf8(p, cp);
+        const char* ascii = transliterate(cp, single);
+        if (ascii) {
+            out.append(ascii, strnlen(ascii, maxChars - out.size()));
+        }
+    }
+    return out;
+}
+
+const std::string& TrackNameCache::get(MediaTrack* track, int id) {
+    const char* name = track ? static_cast<const char*>(GetSetMediaTrackInfo(track, "P_NAME", nullptr)) : nullptr;
+    if (!name) name = "";
+    bool generic = (*name == '\0');
+
+    const GUID* guid = track ? GetTrackGUID(track) : nullptr;
+    if (!guid) {
+        fallback = generic ? "TRACK " + std::to_string(id) : toDisplayName(name, TRACK_NAME_MAX_CHARS);
+        ++conversions;
+        return fallback;
+    }
+    GuidKey key = makeGuidKey(guid);
+
+    if (entries.size() >= MAX_ENTRIES && entries.find(key) == entries.end()) {
+        entries.clear();
+    }
+    Entry& entry = entries[key];
+    if (entry.id == -1 || entry.source != name || (generic && entry.id != id)) {
+        entry.source = name;
+        entry.id = id;
+        entry.display = generic ? "TRACK " + std::to_string(id) : toDisplayName(name, TRACK_NAME_MAX_CHARS);
+        ++conversions;
+    }
+    return entry.display;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "GuidKey.h"
+
+class MediaTrack;
+
+// Converts a UTF-8 track name into what the Mk3 display gets: SysEx data bytes are 7 bit, so accented Latin letters
+// and common punctuation are transliterated to ASCII ("Café Ünder" -> "Cafe Under"), control characters are dropped,
+// anything else becomes '?'. The result is cut to at most maxChars characters.
+std::string toDisplayName(const char* utf8, size_t maxChars);
+
+// Track names in display form, keyed by the track's GUID so entries stay valid when tracks are inserted, removed or
+// moved. get() still reads P_NAME (a pointer into REAPER's track) but only converts again when the name differs from
+// the one the entry was made from, or when an unnamed track changed its number ("TRACK n" fallback).
+class TrackNameCache {
+public:
+    const std::string& get(MediaTrack* track, int id);
+    void clear() { entries.clear(); }
+    size_t size() const { return entries.size(); }
+    // Number of names converted since construction, for diagnostics
+    unsigned int conversionCount() const { return conversions; }
+
+private:
+    struct Entry {
+        std::string source; // P_NAME the entry was made from
+        int id = -1; // track number the fallback was made for
+        std::string display;
+    };
+
+    std::unordered_map<GuidKey, Entry, GuidKeyHash> entries;
+    unsigned int conversions = 0;
+    std::string fallback; // for tracks without a GUID
+};
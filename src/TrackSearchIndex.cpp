@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cctype>
+#include "TrackSearchIndex.h"
+#include "TrackNameCache.h"
+#include "reaKontrol.h"
+
+void TrackSearchIndex::addEntries(int id, const std::string& displayName, std::vector<Entry>& out) const {
+    std::string lower(displayName);
+    for (char& c : lower) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    // A word starts after a space, '-', '_' or '.', or at a letter following a digit and vice versa ("Vln2" -> "2")
+    for (size_t i = 0; i < lower.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(lower[i]);
+        if (c == ' ' || c == '-' || c == '_' || c == '.') continue;
+        bool wordStart = (i == 0);
+        if (!wordStart) {
+            unsigned char prev = static_cast<unsigned char>(lower[i - 1]);
+            wordStart = prev == ' ' || prev == '-' || prev == '_' || prev == '.' || (isdigit(c) != 0) != (isdigit(prev) != 0);
+        }
+        if (wordStart) {
+            out.push_back(Entry{ lower.substr(i), id, i == 0 });
+        }
+    }
+}
+
+void TrackSearchIndex::build(TrackNameCache& trackNames) {
+    if (built) return;
+    int numTracks = CSurf_NumTracks(false);
+    entries.clear();
+    names.assign(numTracks + 1, std::string());
+    for (int id = 1; id <= numTracks; ++id) {
+        MediaTrack* track = CSurf_TrackFromID(id, false);
+        if (!track) continue;
+        names[id] = trackNames.get(track, id);
+        addEntries(id, names[id], entries);
+    }
+    std::sort(entries.begin(), entries.end());
+    built = true;
+    stale = false;
+    ++builds;
+}
+
+bool TrackSearchIndex::refresh(TrackNameCache& trackNames) {
+    if (!stale) return false;
+    stale = false;
+    bool renamed = false;
+    for (int id = 1; id < static_cast<int>(names.size()); ++id) {
+        MediaTrack* track = CSurf_TrackFromID(id, false);
+        if (track) renamed |= rename(id, trackNames.get(track, id));
+    }
+    return renamed;
+}
+
+bool TrackSearchIndex::rename(int id, const std::string& displayName) {
+    if (!built || id < 1 || id >= static_cast<int>(names.size()) || names[id] == displayName) return false;
+    std::vector<Entry> changed;
+    addEntries(id, names[id], changed);
+    for (const Entry& old : changed) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), old);
+        if (it != entries.end() && it->key == old.key && it->id == id) {
+            entries.erase(it);
+        }
+    }
+    names[id] = displayName;
+    changed.clear();
+    addEntries(id, displayName, changed);
+    for (Entry& entry : changed) {
+        entries.insert(std::upper_bound(entries.begin(), entries.end(), entry), std::move(entry));
+    }
+    return true;
+}
+
+void TrackSearchIndex::find(const std::string& prefix, std::vector<int>& ids) const {
+    ids.clear();
+    Entry first{ prefix, 0, false };
+    std::vector<int> inside; // matches at a later word
+    for (auto it = std::lower_bound(entries.begin(), entries.end(), first);
+        it != entries.end() && it->key.compare(0, prefix.size(), prefix) == 0; ++it) {
+        (it->nameStart ? ids : inside).push_back(it->id);
+    }
+    std::sort(ids.begin(), ids.end());
+    std::sort(inside.begin(), inside.end());
+    inside.erase(std::unique(inside.begin(), inside.end()), inside.end());
+    size_t starts = ids.size();
+    for (int id : inside) {
+        if (!std::binary_search(ids.begin(), ids.begin() + starts, id)) {
+            ids.push_back(id);
+        }
+    }
+}
+
+std::string TrackSearchIndex::nextChars(const std::string& prefix) const {
+    // Jump from one continuation character to the next instead of visiting every match
+    std::string chars;
+    Entry probe{ prefix, 0, false };
+    auto it = std::lower_bound(entries.begin(), entries.end(), probe);
+    while (it != entries.end() && it->key.compare(0, prefix.size(), prefix) == 0) {
+        if (it->key.size() > prefix.size()) {
+            unsigned char c = static_cast<unsigned char>(it->key[prefix.size()]);
+            chars.push_back(static_cast<char>(c));
+            if (c == 0xFF) break;
+            probe.key = prefix + static_cast<char>(c + 1);
+            it = std::lower_bound(it, entries.end(), probe);
+        }
+        else {
+            ++it; // the whole key is the prefix
+        }
+    }
+    return chars;
+}
+
+const std::string& TrackSearchIndex::name(int id) const {
+    return (id >= 0 && id < static_cast<int>(names.size())) ? names[id] : none;
+}
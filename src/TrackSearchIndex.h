@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class TrackNameCache;
+
+// Track names for the jump to track mode: every word start of every track name in lower case, sorted. A prefix
+// lookup is a binary search plus a scan over the matches, well below a millisecond for thousands of tracks. Built
+// from the TrackNameCache the first time it is needed after invalidate() (track list changed); renamed tracks are
+// updated in place by refresh() once names may have changed (markStale()).
+class TrackSearchIndex {
+public:
+    void invalidate() { built = false; }
+    bool isBuilt() const { return built; }
+    void build(TrackNameCache& names);
+    // Some track may have been renamed since the last build() / refresh()
+    void markStale() { stale = built; }
+    bool isStale() const { return stale; }
+    // Compare all indexed names against the tracks and update the renamed ones, true if any changed
+    bool refresh(TrackNameCache& names);
+    // Name of track number id is now displayName (display form), false if that is what the index has already or the
+    // index isn't built
+    bool rename(int id, const std::string& displayName);
+    // Tracks with a word starting with prefix: names starting with it first, then by track number
+    void find(const std::string& prefix, std::vector<int>& ids) const;
+    // Characters that continue prefix to a query that still has matches, in ascending order
+    std::string nextChars(const std::string& prefix) const;
+    // Display name of track number id as indexed
+    const std::string& name(int id) const;
+    // Number of builds since construction, for diagnostics
+    unsigned int buildCount() const { return builds; }
+
+private:
+    struct Entry {
+        std::string key; // lower case, from a word start to the end of the name
+        int id;
+        bool nameStart;
+        bool operator<(const Entry& other) const { return key < other.key || (key == other.key && id < other.id); }
+    };
+
+    void addEntries(int id, const std::string& displayName, std::vector<Entry>& out) const;
+
+    std::vector<Entry> entries;
+    std::vector<std::string> names; // by track number
+    std::string none;
+    bool built = false;
+    bool stale = false;
+    unsigned int builds = 0;
+};
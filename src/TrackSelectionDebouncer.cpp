@@ -1,26 +1,35 @@
 #include "TrackSelectionDebouncer.h"
+#include <algorithm>
 
 void TrackSelectionDebouncer::update(int trackId, bool selected) {
-    selectionMap[trackId] = selected;
-    lastUpdate = std::chrono::steady_clock::now();
-}
-
-bool TrackSelectionDebouncer::shouldFallbackToMaster() {
-    if (selectionMap.empty()) return false;
-
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdate).count();
-
-    if (elapsed < debounceMs) return false;
-
-    for (const auto& [_, isSelected] : selectionMap)
-    {
-        if (isSelected) return false;
+    if (trackId < 0) return;
+    anyReported = true;
+    size_t word = static_cast<size_t>(trackId) / 64;
+    uint64_t mask = uint64_t(1) << (trackId % 64);
+    if (word >= selectedBits.size()) {
+        if (!selected) return; // not set anyway
+        selectedBits.resize(word + 1, 0);
     }
+    bool wasSelected = (selectedBits[word] & mask) != 0;
+    if (selected == wasSelected) return;
+    if (selected) {
+        selectedBits[word] |= mask;
+        ++selectedCount;
+    }
+    else {
+        selectedBits[word] &= ~mask;
+        --selectedCount;
+    }
+}
 
-    return true; // no track selected → fallback to master
+bool TrackSelectionDebouncer::shouldFallbackToMaster() const {
+    return anyReported && selectedCount == 0; // no track selected → fallback to master
 }
 
 void TrackSelectionDebouncer::reset() {
-    selectionMap.clear();
+    if (selectedCount > 0) {
+        std::fill(selectedBits.begin(), selectedBits.end(), 0);
+        selectedCount = 0;
+    }
+    anyReported = false;
 }
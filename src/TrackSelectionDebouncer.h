@@ -1,15 +1,20 @@
 #pragma once
-#include <unordered_map>
-#include <chrono>
+#include <cstdint>
+#include <vector>
 
+// Collects the selection states reported by SetSurfaceSelected(). The surface decides about the master track fallback
+// once no further changes arrived for g_selectionDebounceMs (timer on the surface's TimerWheel).
+// REAPER reports every track on any selection change, so the states are kept in a bitset indexed by track id with a
+// running count of selected tracks: a report costs O(1) and "is anything selected?" needs no scan.
 class TrackSelectionDebouncer {
 public:
     void update(int trackId, bool selected);
-    bool shouldFallbackToMaster(); // call this from Run()
+    bool shouldFallbackToMaster() const; // call this once the selection settled
     void reset();
+    int getSelectedCount() const { return selectedCount; }
 
 private:
-    std::unordered_map<int, bool> selectionMap;
-    std::chrono::steady_clock::time_point lastUpdate;
-    const int debounceMs = 100;
+    std::vector<uint64_t> selectedBits;
+    int selectedCount = 0;
+    bool anyReported = false;
 };
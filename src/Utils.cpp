@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <cmath>
 #include <string>
@@ -7,8 +9,10 @@
 #include "reaKontrol.h"
 #include "ActionList.h"
 #include "Constants.h"
+#include "SurfaceContext.h"
 #include "Commands.h"
 #include "MidiSender.h"
+#include "TimerWheel.h"
 #include <sstream>
 #include <reaper/reaper_plugin.h>
 #include <reaper/reaper_plugin_functions.h>
@@ -16,11 +20,6 @@
 static const char KK_VST_PREFIX[] = "VSTi: Kontakt";
 static char KK_VST3_PREFIX[] = "VST3i: Kontakt";
 
-static const char* kk_device_names[] = {
-    "MIDIIN2 (KONTROL S61 MK3)",
-    "MIDIOUT2 (KONTROL S61 MK3)"
-};
-
 static reaper_plugin_info_t* g_rec = nullptr;
 static std::unordered_map<int, std::function<void()>> g_actionCallbacks;
 static std::unordered_map<int, gaccel_register_t> g_registeredActions;
@@ -107,38 +106,6 @@ void UnregisterAllActions() {
     g_actionDescriptions.clear();
 }
 
-int getKkMidiInput() {
-    int count = GetNumMIDIInputs();
-    for (int dev = 0; dev < count; ++dev) {
-        char name[60];
-        bool present = GetMIDIInputName(dev, name, sizeof(name));
-        if (!present) continue;
-
-        for (int i = 0; kk_device_names[i] != nullptr; ++i) {
-            if (strstr(name, kk_device_names[i])) {
-                return dev;
-            }
-        }
-    }
-    return -1;
-}
-
-int getKkMidiOutput() {
-    int count = GetNumMIDIOutputs();
-    for (int dev = 0; dev < count; ++dev) {
-        char name[60];
-        bool present = GetMIDIOutputName(dev, name, sizeof(name));
-        if (!present) continue;
-
-        for (int i = 0; kk_device_names[i] != nullptr; ++i) {
-            if (strstr(name, kk_device_names[i])) {
-                return dev;
-            }
-        }
-    }
-    return -1;
-}
-
 signed char convertSignedMidiValue(unsigned char value) {
     return (value <= 63) ? value : value - 128;
 }
@@ -190,44 +157,70 @@ void showTempoInMixer(MidiSender* midiSender) {
     }
 }
 
-void allMixerUpdate(MidiSender* midiSender) {
+void showPositionInMixer(SurfaceContext& ctx, MidiSender* midiSender, int numInBank, const std::string& name, double position) {
+    if (numInBank < 0 || numInBank >= BANK_NUM_TRACKS) return;
+    if (ctx.positionSlot >= 0 && ctx.positionSlot != numInBank) {
+        ctx.positionUntil = 0; // another slot still shows the last jump
+        positionTextUpdate(ctx, midiSender);
+    }
+    // The slot's own volume / pan text is sent again with its next change or by positionTextUpdate()
+    SlotValueCache& slot = ctx.slots[numInBank];
+    slot.volKey = SlotValueCache::NO_KEY;
+    slot.volText[0] = '\0';
+    slot.panKey = SlotValueCache::NO_KEY;
+    slot.panText[0] = '\0';
+    char positionText[64] = { 0 };
+    format_timestr_pos(position, positionText, sizeof(positionText), -1); // project time format
+    midiSender->sendSysex(CMD_TRACK_VOLUME_TEXT, 0, numInBank, name);
+    midiSender->sendSysex(CMD_TRACK_PAN_TEXT, 0, numInBank, positionText);
+    ctx.positionSlot = numInBank;
+    ctx.positionUntil = monotonicMs() + POSITION_TEXT_MS;
+}
+
+void positionTextUpdate(SurfaceContext& ctx, MidiSender* midiSender) {
+    if (ctx.positionSlot < 0 || monotonicMs() < ctx.positionUntil) return;
+    int numInBank = ctx.positionSlot;
+    ctx.positionSlot = -1;
+    int id = ctx.bank.trackAt(ctx.state.bankStart + numInBank);
+    MediaTrack* track = (id >= 0) ? CSurf_TrackFromID(id, false) : nullptr;
+    if (!track) return;
+    sendSlotVolume(ctx, midiSender, numInBank, *(double*)GetSetMediaTrackInfo(track, "D_VOL", nullptr), true);
+    sendSlotPan(ctx, midiSender, numInBank, *(double*)GetSetMediaTrackInfo(track, "D_PAN", nullptr), true);
+}
+
+void allMixerUpdate(SurfaceContext& ctx, MidiSender* midiSender) {
     debugLog("allMixerUpdate");
     int numInBank = 0;
-    bankEnd = bankStart + BANK_NUM_TRACKS - 1; // avoid ambiguity: track counting always zero based
-    int numTracks = CSurf_NumTracks(false);
+    ctx.state.bankEnd = ctx.state.bankStart + BANK_NUM_TRACKS - 1; // avoid ambiguity: track counting always zero based
+    // Banks are counted in positions of the bank layout: tracks filtered out of it take no slot
+    int lastPos = ctx.bank.size() - 1;
     // Update bank select button lights
     // ToDo: Consider optimizing this piece of code
     int bankLights = 3; // left and right on
-    if (numTracks < BANK_NUM_TRACKS) {
+    if (lastPos < BANK_NUM_TRACKS) {
         bankLights = 0; // left and right off
     }
-    else if (bankStart == 0) {
+    else if (ctx.state.bankStart == 0) {
         bankLights = 2; // left off, right on
     }
-    else if (bankEnd >= numTracks) {
+    else if (ctx.state.bankEnd >= lastPos) {
         bankLights = 1; // left on, right off
     }
     midiSender->sendCc(CMD_NAV_BANKS, bankLights);
-    if (bankEnd > numTracks) {
-        bankEnd = numTracks;
+    if (ctx.state.bankEnd > lastPos) {
+        ctx.state.bankEnd = lastPos;
         // Mark additional bank tracks as not available
-        int lastInLastBank = numTracks % BANK_NUM_TRACKS;
+        int lastInLastBank = lastPos % BANK_NUM_TRACKS;
         for (int i = 7; i > lastInLastBank; --i) {
             midiSender->sendSysex(CMD_TRACK_AVAIL, 0, i);
         }
     }
     // Update 4D Encoder track navigation LEDs
-    int trackNavLights = 3; // left and right on
-    if (g_trackInFocus < 2) {
-        trackNavLights &= 2; // left off
-    }
-    if (g_trackInFocus >= numTracks) {
-        trackNavLights &= 1; // right off
-    }
-    midiSender->sendCc(CMD_NAV_TRACKS, trackNavLights);
+    midiSender->sendCc(CMD_NAV_TRACKS, trackNavLights(ctx));
     // Update current bank
-    for (int id = bankStart; id <= bankEnd; ++id, ++numInBank) {
-        MediaTrack* track = CSurf_TrackFromID(id, false);
+    for (int pos = ctx.state.bankStart; pos <= ctx.state.bankEnd; ++pos, ++numInBank) {
+        int id = ctx.bank.trackAt(pos);
+        MediaTrack* track = (id >= 0) ? CSurf_TrackFromID(id, false) : nullptr;
         if (!track) {
             break;
         }
@@ -244,41 +237,343 @@ void allMixerUpdate(MidiSender* midiSender) {
             midiSender->sendSysex(CMD_TRACK_AVAIL, TRTYPE_UNSPEC, numInBank);
             int soloState = *(int*)GetSetMediaTrackInfo(track, "I_SOLO", nullptr);
             if (soloState == 0) {
-                g_soloStateBank[numInBank] = 0;
+                ctx.state.soloStateBank[numInBank] = 0;
                 midiSender->sendSysex(CMD_TRACK_SOLOED, 0, numInBank);
-                midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, g_anySolo ? 1 : 0, numInBank);
+                midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, ctx.state.anySolo ? 1 : 0, numInBank);
             }
             else {
-                g_soloStateBank[numInBank] = 1;
+                ctx.state.soloStateBank[numInBank] = 1;
                 midiSender->sendSysex(CMD_TRACK_SOLOED, 1, numInBank);
                 midiSender->sendSysex(CMD_TRACK_MUTED_BY_SOLO, 0, numInBank);
             }
             int armed = *(int*)GetSetMediaTrackInfo(track, "I_RECARM", nullptr);
             midiSender->sendSysex(CMD_TRACK_ARMED, armed, numInBank);
-            char* name = (char*)GetSetMediaTrackInfo(track, "P_NAME", nullptr);
-            if ((!name) || (*name == '\0')) {
-                std::string s = "TRACK " + std::to_string(id);
-                std::vector<char> nameGeneric(s.begin(), s.end()); // memory safe conversion to C style char
-                nameGeneric.push_back('\0');
-                name = &nameGeneric[0];
-            }
-            midiSender->sendSysex(CMD_TRACK_NAME, 0, numInBank, name);
+            midiSender->sendSysex(CMD_TRACK_NAME, 0, numInBank, ctx.trackNames.get(track, id));
         }
-        midiSender->sendSysex(CMD_TRACK_SELECTED, id == g_trackInFocus ? 1 : 0, numInBank);
+        midiSender->sendSysex(CMD_TRACK_SELECTED, id == ctx.state.trackInFocus ? 1 : 0, numInBank);
         bool muted = *(bool*)GetSetMediaTrackInfo(track, "B_MUTE", nullptr);
-        g_muteStateBank[numInBank] = muted;
+        ctx.state.muteStateBank[numInBank] = muted;
         midiSender->sendSysex(CMD_TRACK_MUTED, muted ? 1 : 0, numInBank);
         double volume = *(double*)GetSetMediaTrackInfo(track, "D_VOL", nullptr);
-        char volText[64];
-        mkvolstr(volText, volume);
-        midiSender->sendSysex(CMD_TRACK_VOLUME_TEXT, 0, numInBank, volText);
-        midiSender->sendCc((CMD_KNOB_VOLUME0 + numInBank), volToChar_KkMk3(volume * 1.05925));
+        sendSlotVolume(ctx, midiSender, numInBank, volume, true);
         double pan = *(double*)GetSetMediaTrackInfo(track, "D_PAN", nullptr);
-        char panText[64];
+        sendSlotPan(ctx, midiSender, numInBank, pan, true); // NIHIA v1.8.7.135 uses internal text
+    }
+}
+
+unsigned char trackNavLights(SurfaceContext& ctx) {
+    // Left / right along the bank layout, the way track navigation moves. A focused track that is filtered out of the
+    // layout counts as sitting just before the next one that isn't.
+    int pos = ctx.bank.rankOf(ctx.state.trackInFocus);
+    unsigned char lights = 3; // left and right on
+    if (pos < 2) {
+        lights &= 2; // left off
+    }
+    if (pos >= ctx.bank.size() - 1) {
+        lights &= 1; // right off
+    }
+    return lights;
+}
+
+double navigationTime() {
+    return (GetPlayState() & 1) ? GetPlayPosition() : GetCursorPosition();
+}
+
+unsigned char clipNavLights(SurfaceContext& ctx) {
+    double time = navigationTime();
+    bool before = ctx.markers.previous(time) != nullptr;
+    bool after = ctx.markers.next(time) != nullptr;
+    return static_cast<unsigned char>((before ? 1 : 0) | (after ? 2 : 0));
+}
+
+void sendSlotVolume(SurfaceContext& ctx, MidiSender* midiSender, int numInBank, double volume, bool refresh) {
+    if (numInBank < 0 || numInBank >= BANK_NUM_TRACKS) return;
+    SlotValueCache& slot = ctx.slots[numInBank];
+    // mkvolstr shows "-inf" far below anything audible, everything under -150 dB shares one key
+    double dB = (volume > 0.0) ? 20.0 * log10(volume) : -1000.0;
+    int key = (dB < -150.0) ? SlotValueCache::NO_KEY + 1 : static_cast<int>(lround(dB * 100.0));
+    bool textChanged = (key != slot.volKey);
+    if (textChanged) {
+        char volText[64] = { 0 };
+        mkvolstr(volText, volume);
+        textChanged = (strcmp(volText, slot.volText) != 0);
+        slot.volKey = key;
+        memcpy(slot.volText, volText, sizeof(volText));
+    }
+    if (textChanged || refresh) {
+        midiSender->sendSysex(CMD_TRACK_VOLUME_TEXT, 0, numInBank, slot.volText);
+    }
+    int knob = volToChar_KkMk3(volume * 1.05925);
+    if (knob != slot.volKnob || refresh) {
+        slot.volKnob = knob;
+        midiSender->sendCc((CMD_KNOB_VOLUME0 + numInBank), static_cast<unsigned char>(knob));
+    }
+}
+
+void sendSlotPan(SurfaceContext& ctx, MidiSender* midiSender, int numInBank, double pan, bool refresh) {
+    if (numInBank < 0 || numInBank >= BANK_NUM_TRACKS) return;
+    SlotValueCache& slot = ctx.slots[numInBank];
+    int key = static_cast<int>(lround(pan * 100.0));
+    bool textChanged = (key != slot.panKey);
+    if (textChanged) {
+        char panText[64] = { 0 };
         mkpanstr(panText, pan);
-        midiSender->sendSysex(CMD_TRACK_PAN_TEXT, 0, numInBank, panText); // NIHIA v1.8.7.135 uses internal text
-        midiSender->sendCc((CMD_KNOB_PAN0 + numInBank), panToChar(pan));
+        textChanged = (strcmp(panText, slot.panText) != 0);
+        slot.panKey = key;
+        memcpy(slot.panText, panText, sizeof(panText));
+    }
+    if (textChanged || refresh) {
+        midiSender->sendSysex(CMD_TRACK_PAN_TEXT, 0, numInBank, slot.panText);
+    }
+    int knob = panToChar(pan);
+    if (knob != slot.panKnob || refresh) {
+        slot.panKnob = knob;
+        midiSender->sendCc((CMD_KNOB_PAN0 + numInBank), static_cast<unsigned char>(knob));
+    }
+}
+
+// Frame of a page shown in place of the mixer (FX parameters, routes, search results): bank lights for paging, the
+// track lights of all slots off (but the mute lights where the mode shows its own), slots past count blank, placeholder
+// with placeholderText below it in the first slot when there is nothing to show. The mode encodes its own content with
+// encodeSlot(numInBank, index) for the other slots.
+template <typename EncodeSlot>
+static void encodeHiddenMixerPage(std::vector<unsigned char>& out, int page, int numPages, int count, bool ownMuteLights,
+    const char* placeholder, const std::string& placeholderText, EncodeSlot encodeSlot) {
+    int bankLights = (page > 0 ? 1 : 0) | (page + 1 < numPages ? 2 : 0); // left / right
+    MidiSender::encodeCc(out, CMD_NAV_BANKS, static_cast<unsigned char>(bankLights));
+    for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+        int index = page * BANK_NUM_TRACKS + i;
+        unsigned char numInBank = static_cast<unsigned char>(i);
+        MidiSender::encodeSysex(out, CMD_TRACK_SELECTED, 0, numInBank);
+        if (!ownMuteLights || index >= count) {
+            MidiSender::encodeSysex(out, CMD_TRACK_MUTED, 0, numInBank);
+        }
+        MidiSender::encodeSysex(out, CMD_TRACK_SOLOED, 0, numInBank);
+        MidiSender::encodeSysex(out, CMD_TRACK_MUTED_BY_SOLO, 0, numInBank);
+        MidiSender::encodeSysex(out, CMD_TRACK_ARMED, 0, numInBank);
+        if (index < count) {
+            encodeSlot(numInBank, index);
+            continue;
+        }
+        bool showPlaceholder = (placeholder && count == 0 && i == 0);
+        MidiSender::encodeSysex(out, CMD_TRACK_AVAIL, showPlaceholder ? TRTYPE_UNSPEC : 0, numInBank);
+        MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, numInBank, showPlaceholder ? placeholder : "");
+        MidiSender::encodeSysex(out, CMD_TRACK_VOLUME_TEXT, 0, numInBank, " ");
+        MidiSender::encodeSysex(out, CMD_TRACK_PAN_TEXT, 0, numInBank, showPlaceholder ? placeholderText : std::string(" "));
+        MidiSender::encodeCc(out, static_cast<unsigned char>(CMD_KNOB_VOLUME0 + numInBank), 0);
+        MidiSender::encodeCc(out, static_cast<unsigned char>(CMD_KNOB_PAN0 + numInBank), 0);
     }
+    static const char clearPeak[(BANK_NUM_TRACKS * 2) + 1] = { 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,0 };
+    MidiSender::encodeSysex(out, CMD_TRACK_VU, 2, 0, clearPeak);
+}
+
+void fxParamUpdate(SurfaceContext& ctx, MidiSender* midiSender, bool refresh) {
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
+    if (track != ctx.fxShown.track) {
+        // Focus moved to another track: start with its first FX
+        ctx.fxIndex = 0;
+        ctx.fxPage = 0;
+    }
+    int fxCount = track ? TrackFX_GetCount(track) : 0;
+    ctx.fxIndex = std::max(0, std::min(ctx.fxIndex, fxCount - 1));
+    FxParamCache::Fx* fx = (fxCount > 0) ? ctx.fxParams.find(track, ctx.fxIndex) : nullptr;
+    int numParams = fx ? static_cast<int>(fx->params.size()) : 0;
+    int numPages = std::max(1, (numParams + BANK_NUM_TRACKS - 1) / BANK_NUM_TRACKS);
+    ctx.fxPage = std::max(0, std::min(ctx.fxPage, numPages - 1));
+
+    // Everything goes through the display shadow: frames a new page has in common with the last one aren't sent again
+    std::vector<unsigned char> out;
+    SurfaceContext::FxView view;
+    view.track = track;
+    view.fx = fx;
+    view.generation = ctx.fxParams.generation();
+    view.page = ctx.fxPage;
+    view.numParams = numParams;
+    if (refresh || view.track != ctx.fxShown.track || view.fx != ctx.fxShown.fx || view.generation != ctx.fxShown.generation ||
+        view.page != ctx.fxShown.page || view.numParams != ctx.fxShown.numParams) {
+        debugLog("fxParamUpdate: FX " + std::to_string(ctx.fxIndex) + ", page " + std::to_string(ctx.fxPage));
+        ctx.fxShown = view;
+        char fxName[128] = { 0 };
+        if (fx) {
+            TrackFX_GetFXName(track, ctx.fxIndex, fxName, sizeof(fxName));
+        }
+        for (FxSlotCache& slot : ctx.fxSlots) {
+            slot = FxSlotCache();
+        }
+        encodeHiddenMixerPage(out, ctx.fxPage, numPages, numParams, false, fx ? nullptr : "No FX", " ",
+            [&](unsigned char numInBank, int index) {
+                ctx.fxSlots[numInBank].param = index;
+                const FxParamInfo& info = ctx.fxParams.param(track, ctx.fxIndex, *fx, index);
+                MidiSender::encodeCc(out, static_cast<unsigned char>(CMD_KNOB_PAN0 + numInBank), 0);
+                MidiSender::encodeSysex(out, CMD_TRACK_AVAIL, TRTYPE_UNSPEC, numInBank);
+                MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, numInBank, info.name);
+                // The FX name goes below the first parameter
+                MidiSender::encodeSysex(out, CMD_TRACK_PAN_TEXT, 0, numInBank,
+                    (numInBank == 0) ? toDisplayName(fxName, TRACK_NAME_MAX_CHARS) : std::string(" "));
+            });
+    }
+
+    // Values of the shown parameters, formatted by the plugin itself only when they changed
+    for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+        FxSlotCache& slot = ctx.fxSlots[i];
+        if (slot.param < 0) continue;
+        double value = TrackFX_GetParamNormalized(track, ctx.fxIndex, slot.param);
+        if (value == slot.value) continue;
+        slot.value = value;
+        char valueText[128] = { 0 };
+        if (!TrackFX_GetFormattedParamValue(track, ctx.fxIndex, slot.param, valueText, sizeof(valueText)) ||
+            valueText[0] == '\0') {
+            snprintf(valueText, sizeof(valueText), "%.1f%%", value * 100.0);
+        }
+        MidiSender::encodeSysex(out, CMD_TRACK_VOLUME_TEXT, 0, static_cast<unsigned char>(i),
+            toDisplayName(valueText, TRACK_NAME_MAX_CHARS));
+        int knob = static_cast<int>(lround(std::max(0.0, std::min(value, 1.0)) * 127.0));
+        if (knob != slot.knob) {
+            slot.knob = knob;
+            MidiSender::encodeCc(out, static_cast<unsigned char>(CMD_KNOB_VOLUME0 + i), static_cast<unsigned char>(knob));
+        }
+    }
+    if (!out.empty()) {
+        midiSender->sendEncoded(out);
+    }
+}
+
+bool adjustFxParam(SurfaceContext& ctx, int numInBank, signed char midiDelta) {
+    if (numInBank < 0 || numInBank >= BANK_NUM_TRACKS || midiDelta == 0) return false;
+    const FxSlotCache& slot = ctx.fxSlots[numInBank];
+    MediaTrack* track = ctx.fxShown.track;
+    FxParamCache::Fx* fx = ctx.fxParams.find(track, ctx.fxIndex);
+    if (slot.param < 0 || !fx || fx != ctx.fxShown.fx || slot.param >= static_cast<int>(fx->params.size())) return false;
+
+    const FxParamInfo& info = ctx.fxParams.param(track, ctx.fxIndex, *fx, slot.param);
+    double value = TrackFX_GetParamNormalized(track, ctx.fxIndex, slot.param);
+    if (info.isToggle) {
+        value = (midiDelta > 0) ? 1.0 : 0.0;
+    }
+    else if (info.step > 0.0) {
+        // Stepped parameters (modes, waveforms...) move one step per knob message
+        value += (midiDelta > 0) ? info.step : -info.step;
+    }
+    else {
+        value += midiDelta * FX_KNOB_STEP;
+    }
+    TrackFX_SetParamNormalized(track, ctx.fxIndex, slot.param, std::max(0.0, std::min(value, 1.0)));
+    return true;
+}
+
+void routePageUpdate(SurfaceContext& ctx, MidiSender* midiSender, bool refresh) {
+    MediaTrack* track = CSurf_TrackFromID(ctx.state.trackInFocus, false);
+    if (track != ctx.routesShown.track) {
+        // Focus moved to another track: its sends, or its receives if it has none (e.g. a bus)
+        ctx.routeCategory = (track && GetTrackNumSends(track, ROUTE_SENDS) > 0) ? ROUTE_SENDS : ROUTE_RECEIVES;
+        ctx.routePage = 0;
+    }
+    const std::vector<Route>& routes = ctx.routing.routes(track, ctx.routeCategory);
+    int count = static_cast<int>(routes.size());
+    int numPages = std::max(1, (count + BANK_NUM_TRACKS - 1) / BANK_NUM_TRACKS);
+    ctx.routePage = std::max(0, std::min(ctx.routePage, numPages - 1));
+
+    SurfaceContext::RouteView view;
+    view.track = track;
+    view.category = ctx.routeCategory;
+    view.generation = ctx.routing.generation();
+    view.page = ctx.routePage;
+    view.count = count;
+    bool redraw = refresh || view.track != ctx.routesShown.track || view.category != ctx.routesShown.category ||
+        view.generation != ctx.routesShown.generation || view.page != ctx.routesShown.page || view.count != ctx.routesShown.count;
+    if (redraw) {
+        debugLog("routePageUpdate: " + std::string(view.category == ROUTE_SENDS ? "sends" : "receives") + ", page " +
+            std::to_string(ctx.routePage));
+        ctx.routesShown = view;
+        // Names through the display shadow like FX mode, the values follow below with refresh set
+        std::vector<unsigned char> out;
+        for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+            ctx.routeMuted[i] = 0;
+        }
+        encodeHiddenMixerPage(out, ctx.routePage, numPages, count, true,
+            view.category == ROUTE_SENDS ? "No sends" : "No receives", " ",
+            [&](unsigned char numInBank, int index) {
+                const Route& route = routes[index];
+                ctx.routeMuted[numInBank] = -1;
+                MidiSender::encodeSysex(out, CMD_TRACK_AVAIL, TRTYPE_UNSPEC, numInBank);
+                MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, numInBank,
+                    route.other ? ctx.trackNames.get(route.other, route.otherId) : std::string());
+            });
+        midiSender->sendEncoded(out);
+    }
+
+    // Values of the shown routes: the slot caches only let through what changed
+    int shown = std::min(BANK_NUM_TRACKS, count - ctx.routePage * BANK_NUM_TRACKS);
+    for (int i = 0; i < shown; ++i) {
+        int index = ctx.routePage * BANK_NUM_TRACKS + i;
+        double* volume = (double*)GetSetTrackSendInfo(track, ctx.routeCategory, index, "D_VOL", nullptr);
+        double* pan = (double*)GetSetTrackSendInfo(track, ctx.routeCategory, index, "D_PAN", nullptr);
+        bool* muted = (bool*)GetSetTrackSendInfo(track, ctx.routeCategory, index, "B_MUTE", nullptr);
+        if (volume) sendSlotVolume(ctx, midiSender, i, *volume, redraw);
+        if (pan) sendSlotPan(ctx, midiSender, i, *pan, redraw);
+        signed char mute = (muted && *muted) ? 1 : 0;
+        if (mute != ctx.routeMuted[i]) {
+            ctx.routeMuted[i] = mute;
+            midiSender->sendSysex(CMD_TRACK_MUTED, mute, static_cast<unsigned char>(i));
+        }
+    }
+}
+
+bool adjustRoute(SurfaceContext& ctx, int numInBank, signed char midiDelta, bool pan) {
+    if (numInBank < 0 || numInBank >= BANK_NUM_TRACKS || midiDelta == 0) return false;
+    MediaTrack* track = ctx.routesShown.track;
+    int index = ctx.routesShown.page * BANK_NUM_TRACKS + numInBank;
+    if (!track || index >= ctx.routesShown.count) return false;
+    bool send = (ctx.routesShown.category == ROUTE_SENDS);
+    // Same steps as the track knobs
+    if (pan) {
+        double step = midiDelta * 0.00098425;
+        if (send) CSurf_OnSendPanChange(track, index, step, true);
+        else CSurf_OnRecvPanChange(track, index, step, true);
+    }
+    else {
+        double step = (abs(midiDelta) > 38 ? 1.0 : 0.1) * (midiDelta >= 0 ? 1 : -1);
+        if (send) CSurf_OnSendVolumeChange(track, index, step, true);
+        else CSurf_OnRecvVolumeChange(track, index, step, true);
+    }
+    return true;
+}
+
+bool toggleRouteMute(SurfaceContext& ctx, int numInBank) {
+    if (numInBank < 0 || numInBank >= BANK_NUM_TRACKS) return false;
+    MediaTrack* track = ctx.routesShown.track;
+    int index = ctx.routesShown.page * BANK_NUM_TRACKS + numInBank;
+    if (!track || index >= ctx.routesShown.count) return false;
+    bool* muted = (bool*)GetSetTrackSendInfo(track, ctx.routesShown.category, index, "B_MUTE", nullptr);
+    if (!muted) return false;
+    bool mute = !*muted;
+    GetSetTrackSendInfo(track, ctx.routesShown.category, index, "B_MUTE", &mute);
+    return true;
+}
+
+void searchPageUpdate(SurfaceContext& ctx, MidiSender* midiSender) {
+    ctx.trackSearch.build(ctx.trackNames);
+    ctx.trackSearch.refresh(ctx.trackNames); // only renamed tracks change entries, no rebuild
+    ctx.trackSearch.find(ctx.searchQuery, ctx.searchResults);
+    int count = static_cast<int>(ctx.searchResults.size());
+    int numPages = std::max(1, (count + BANK_NUM_TRACKS - 1) / BANK_NUM_TRACKS);
+    ctx.searchPage = std::max(0, std::min(ctx.searchPage, numPages - 1));
+
+    // Through the display shadow: typing a letter mostly changes a few slots only
+    std::vector<unsigned char> out;
+    // The query goes below the first slot
+    std::string query = "Find: " + ctx.searchQuery + "_";
+    encodeHiddenMixerPage(out, ctx.searchPage, numPages, count, false, "No match", query,
+        [&](unsigned char numInBank, int index) {
+            int id = ctx.searchResults[index];
+            MidiSender::encodeCc(out, static_cast<unsigned char>(CMD_KNOB_VOLUME0 + numInBank), 0);
+            MidiSender::encodeCc(out, static_cast<unsigned char>(CMD_KNOB_PAN0 + numInBank), 0);
+            MidiSender::encodeSysex(out, CMD_TRACK_AVAIL, TRTYPE_UNSPEC, numInBank);
+            MidiSender::encodeSysex(out, CMD_TRACK_NAME, 0, numInBank, ctx.trackSearch.name(id));
+            MidiSender::encodeSysex(out, CMD_TRACK_VOLUME_TEXT, 0, numInBank, "#" + std::to_string(id));
+            MidiSender::encodeSysex(out, CMD_TRACK_PAN_TEXT, 0, numInBank, (numInBank == 0) ? query : std::string(" "));
+        });
+    midiSender->sendEncoded(out);
 }
 
 bool isTrackEmpty(MediaTrack* track) {
@@ -293,30 +588,47 @@ void metronomeUpdate(MidiSender* midiSender) {
 }
 
 int getMetronomeState() {
-    return (*(int*)GetConfigVar("projmetroen") & 1);
+    int* metronome = getProjMetroEn();
+    return metronome ? (*metronome & 1) : 0;
 }
 
 void enableRecCountIn() {
-	*(int*)GetConfigVar("projmetroen") |= 16; 
+    if (int* metronome = getProjMetroEn()) {
+        *metronome |= 16;
+    }
 }
 
-void disableRecCountIn() {
-    *(int*)GetConfigVar("projmetroen") &= ~16;
-    g_KKcountInTriggered = false;
+void disableRecCountIn(SurfaceContext& ctx) {
+    if (int* metronome = getProjMetroEn()) {
+        *metronome &= ~16;
+    }
+    ctx.countInTriggered = false;
 }
 
-void* GetConfigVar(const char* cVar) { // Copyright (c) 2010 and later Tim Payne (SWS), Jeffos
-    int sztmp;
-    void* p = NULL;
-    if (int iOffset = projectconfig_var_getoffs(cVar, &sztmp))
-    {
-        p = projectconfig_var_addr(EnumProjects(-1, NULL, 0), iOffset);
+void* ConfigVar::get() { // Lookup: Copyright (c) 2010 and later Tim Payne (SWS), Jeffos
+    if (!resolved) {
+        int sztmp;
+        offset = projectconfig_var_getoffs(name, &sztmp);
+        if (!offset) {
+            addr = get_config_var(name, &sztmp);
+        }
+        resolved = true;
     }
-    else
-    {
-        p = get_config_var(cVar, &sztmp);
+    if (offset) {
+        // EnumProjects(-1) is cheap, trusting an event about project switches instead would risk writing into a
+        // closed project
+        ReaProject* current = EnumProjects(-1, nullptr, 0);
+        if (current != project) {
+            project = current;
+            addr = current ? projectconfig_var_addr(current, offset) : nullptr;
+        }
     }
-    return p;
+    return addr;
+}
+
+int* getProjMetroEn() {
+    static ConfigVar projmetroen("projmetroen");
+    return static_cast<int*>(projmetroen.get());
 }
 
 bool adjustTrackVolume(MediaTrack* track, signed char midiDelta) {
@@ -355,7 +667,7 @@ void updateTrackPeak(MediaTrack* track, int& j, char* peakBank) {
     peakBank[j + 1] = volToChar_KkMk3(peakValue); // returns value between 1 and 127
 }
 
-void peakMixerUpdate(MidiSender* midiSender) {
+void peakMixerUpdate(SurfaceContext& ctx, MidiSender* midiSender) {
     // Peak meters. Note: Reaper reports peak, NOT VU	
 
     // ToDo: Peak Hold in KK display shall be erased immediately when changing bank
@@ -366,12 +678,13 @@ void peakMixerUpdate(MidiSender* midiSender) {
     // Meter information is sent to KK as array (string of chars) for all 16 channels (8 x stereo) of one bank.
     // A value of 0 will result in stopping to refresh meters further to right as it is interpretated as "end of string".
     // peakBank[0]..peakBank[31] are used for data. The array needs one additional last char peakBank[32] set as "end of string" marker.
-    static char peakBank[(BANK_NUM_TRACKS * 2) + 1];
+    char peakBank[(BANK_NUM_TRACKS * 2) + 1] = { 0 };
     int j = 0;
     int numInBank = 0;
 
-    for (int id = bankStart; id <= bankEnd; ++id, ++numInBank) {
-        MediaTrack* track = CSurf_TrackFromID(id, false);
+    for (int pos = ctx.state.bankStart; pos <= ctx.state.bankEnd; ++pos, ++numInBank) {
+        int id = ctx.bank.trackAt(pos);
+        MediaTrack* track = (id >= 0) ? CSurf_TrackFromID(id, false) : nullptr;
         if (!track) {
             break;
         }
@@ -379,8 +692,8 @@ void peakMixerUpdate(MidiSender* midiSender) {
 
         if (HIDE_MUTED_BY_SOLO) {
             // If any track is soloed then only soloed tracks and the master show peaks (irrespective of their mute state)
-            if (g_anySolo) {
-                if ((g_soloStateBank[numInBank] == 0) && (((numInBank != 0) && (bankStart == 0)) || (bankStart != 0))) {
+            if (ctx.state.anySolo) {
+                if ((ctx.state.soloStateBank[numInBank] == 0) && (((numInBank != 0) && (ctx.state.bankStart == 0)) || (ctx.state.bankStart != 0))) {
                     peakBank[j] = 1;
                     peakBank[j + 1] = 1;
                 }
@@ -390,7 +703,7 @@ void peakMixerUpdate(MidiSender* midiSender) {
             }
             // If no tracks are soloed then muted tracks shall show no peaks
             else {
-                if (g_muteStateBank[numInBank]) {
+                if (ctx.state.muteStateBank[numInBank]) {
                     peakBank[j] = 1;
                     peakBank[j + 1] = 1;
                 }
@@ -401,7 +714,7 @@ void peakMixerUpdate(MidiSender* midiSender) {
         }
         else {
             // Muted tracks that are NOT soloed shall show no peaks. Tracks muted by solo show peaks but they appear greyed out.
-            if ((g_soloStateBank[numInBank] == 0) && (g_muteStateBank[numInBank])) {
+            if ((ctx.state.soloStateBank[numInBank] == 0) && (ctx.state.muteStateBank[numInBank])) {
                 peakBank[j] = 1;
                 peakBank[j + 1] = 1;
             }
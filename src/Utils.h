@@ -5,7 +5,9 @@
 #include <functional>
 
 class MidiSender;
+struct SurfaceContext;
 class MediaTrack;
+class ReaProject;
 struct reaper_plugin_info_t;
 
 // Structure to hold action information
@@ -26,12 +28,6 @@ bool RegisterAction(const ReaKontrolAction& action);
 // Unregisters all actions
 void UnregisterAllActions();
 
-// Returns index of matching MIDI input device (or -1 if not found)
-int getKkMidiInput();
-
-// Returns index of matching MIDI output device (or -1 if not found)
-int getKkMidiOutput();
-
 // Convert 7-bit MIDI value to signed char (-64 to +63)
 signed char convertSignedMidiValue(unsigned char value);
 
@@ -43,20 +39,62 @@ unsigned char volToChar_KkMk3(double volume);
 
 bool isTrackEmpty(MediaTrack* track);
 void showTempoInMixer(MidiSender* midiSender);
+// Name and position of a marker or item jumped to, as volume / pan text of a slot until these change again
+void showPositionInMixer(SurfaceContext& ctx, MidiSender* midiSender, int numInBank, const std::string& name, double position);
+// Shows the slot's volume / pan text again once the position was shown for POSITION_TEXT_MS
+void positionTextUpdate(SurfaceContext& ctx, MidiSender* midiSender);
 void metronomeUpdate(MidiSender* midiSender);
-void allMixerUpdate(MidiSender* midiSender);
+void allMixerUpdate(SurfaceContext& ctx, MidiSender* midiSender);
+// CMD_NAV_TRACKS lights for the focused track: bit 0 left, bit 1 right
+unsigned char trackNavLights(SurfaceContext& ctx);
+// Where the up/down navigation starts: the play position while playing, the edit cursor otherwise
+double navigationTime();
+// CMD_NAV_CLIPS lights: bit 0 up (a marker / region before the cursor), bit 1 down (one after it)
+unsigned char clipNavLights(SurfaceContext& ctx);
+// Volume / pan text and knob of a bank slot. Sends only what changed since the last call for the slot (see
+// SlotValueCache), or everything when refresh is set.
+void sendSlotVolume(SurfaceContext& ctx, MidiSender* midiSender, int numInBank, double volume, bool refresh = false);
+void sendSlotPan(SurfaceContext& ctx, MidiSender* midiSender, int numInBank, double pan, bool refresh = false);
+// FX parameter mode: parameters of page ctx.fxPage of FX ctx.fxIndex on the focused track. The whole page is drawn
+// when track, FX or page changed (or refresh is set), otherwise only values that changed since the last call are sent.
+void fxParamUpdate(SurfaceContext& ctx, MidiSender* midiSender, bool refresh = false);
+bool adjustFxParam(SurfaceContext& ctx, int numInBank, signed char midiDelta);
+// Routing mode: sends (or receives) of the focused track, page ctx.routePage. Names are drawn when track, direction or
+// page changed, volume / pan / mute of the shown routes are polled and sent when they changed.
+void routePageUpdate(SurfaceContext& ctx, MidiSender* midiSender, bool refresh = false);
+bool adjustRoute(SurfaceContext& ctx, int numInBank, signed char midiDelta, bool pan);
+bool toggleRouteMute(SurfaceContext& ctx, int numInBank);
+// Jump to track mode: looks up ctx.searchQuery and shows page ctx.searchPage of the matching tracks
+void searchPageUpdate(SurfaceContext& ctx, MidiSender* midiSender);
 int getMetronomeState();
 void enableRecCountIn();
-void disableRecCountIn();
+void disableRecCountIn(SurfaceContext& ctx);
+
+// Config variable looked up by name only once. get() returns its address: for project variables the offset is kept
+// and the address only recomputed when the current project changed (project tab switch), global variables keep their
+// address for good. nullptr if REAPER doesn't know the variable.
+class ConfigVar {
+public:
+    explicit ConfigVar(const char* name) : name(name) {}
+    void* get();
+
+private:
+    const char* name;
+    bool resolved = false;
+    int offset = 0; // 0: global variable
+    ReaProject* project = nullptr;
+    void* addr = nullptr;
+};
 
-void* GetConfigVar(const char* cVar);
+// "projmetroen" of the current project: bit 0 metronome, bit 4 count-in before recording
+int* getProjMetroEn();
 
 bool adjustTrackVolume(MediaTrack* track, signed char midiDelta);
 bool adjustTrackPan(MediaTrack* track, signed char midiDelta);
 
 bool toggleTrackMute(MediaTrack* track);
 bool toggleTrackSolo(MediaTrack* track);
-void peakMixerUpdate(MidiSender* midiSender);
+void peakMixerUpdate(SurfaceContext& ctx, MidiSender* midiSender);
 
 void debugLog(const std::string& msg);
 void debugLog(const std::ostringstream& msgStream);
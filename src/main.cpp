@@ -33,6 +33,8 @@ DWORD GetTickCount()
 #include <string>
 #include <cstring>
 #include <sstream>
+#include <ctime>
+#include <vector>
 
 #define REAPERAPI_IMPLEMENT
 #include "reaKontrol.h"
@@ -40,14 +42,22 @@ DWORD GetTickCount()
 #include "NiMidiSurface.h"
 #include "Utils.h"
 #include "Constants.h"
+#include "MidiTrace.h"
+#include "MidiDeviceCache.h"
+
+#ifdef __APPLE__
+    #define REAKONTROL_TRACE_DIR "/UserPlugins/ReaKontrolConfig/"
+#else
+    #define REAKONTROL_TRACE_DIR "\\UserPlugins\\ReaKontrolConfig\\"
+#endif
 
 
 using namespace std;
 class NiMidiSurface;
 
-extern "C" IReaperControlSurface* createNiMidiSurface();
+extern "C" IReaperControlSurface* createNiMidiSurface(unsigned char surfaceIndex);
 
-BaseSurface::BaseSurface() {}
+BaseSurface::BaseSurface(unsigned char surfaceIndex) : _surfaceIndex(surfaceIndex) {}
 
 BaseSurface::~BaseSurface() {
 	if (this->_midiIn)  {
@@ -67,12 +77,39 @@ void BaseSurface::Run() {
 	MIDI_eventlist* list = this->_midiIn->GetReadBuf();
 	MIDI_event_t* evt;
 	int i = 0;
+	if (g_midiTrace) {
+		g_midiTrace->record(TRACE_TICK, _surfaceIndex);
+	}
 	while ((evt = list->EnumItems(&i))) {
+		if (g_midiTrace) {
+			g_midiTrace->record(TRACE_IN, _surfaceIndex, evt->midi_message, evt->size);
+		}
 		this->_onMidiEvent(evt);
 	}
 }
 
-IReaperControlSurface* surface = nullptr;
+// One surface per keyboard, each registered as its own csurf_inst
+static std::vector<IReaperControlSurface*> surfaces;
+
+static void toggleMidiCapture() {
+	if (g_midiTrace) {
+		std::string path = g_midiTrace->path();
+		delete g_midiTrace;
+		g_midiTrace = nullptr;
+		ShowConsoleMsg(("ReaKontrol: MIDI capture saved to " + path + "\n").c_str());
+		return;
+	}
+	std::string path = std::string(GetResourcePath()) + REAKONTROL_TRACE_DIR + "reakontrol-" + std::to_string((long long)time(nullptr)) + ".rktrace";
+	MidiTraceWriter* trace = new MidiTraceWriter();
+	if (trace->open(path)) {
+		g_midiTrace = trace;
+		ShowConsoleMsg(("ReaKontrol: MIDI capture started: " + path + "\n").c_str());
+	}
+	else {
+		delete trace;
+		ShowConsoleMsg(("ReaKontrol: unable to create MIDI capture file " + path + "\n").c_str());
+	}
+}
 
 extern "C" {
 	REAPER_PLUGIN_DLL_EXPORT int REAPER_PLUGIN_ENTRYPOINT(REAPER_PLUGIN_HINSTANCE hInstance, reaper_plugin_info_t* rec) {
@@ -82,11 +119,14 @@ extern "C" {
 				return 0;
 			}
 
-			// Keep a pointer to IReaperControlSurface
-			surface = createNiMidiSurface();
-
-			// Register the control surface
-			rec->Register("csurf_inst", (void*)surface);
+			// One surface per keyboard plugged in at startup, at least one to wait for a keyboard. Every surface
+			// connects to the first keyboard not taken by another one.
+			size_t numKeyboards = MidiDeviceCache().find().size();
+			for (size_t i = 0; i < numKeyboards || i == 0; ++i) {
+				IReaperControlSurface* surface = createNiMidiSurface(static_cast<unsigned char>(i));
+				surfaces.push_back(surface);
+				rec->Register("csurf_inst", (void*)surface);
+			}
 			
 			// Initialize the action registry
 			InitActionRegistry(rec);
@@ -99,25 +139,43 @@ extern "C" {
 					g_debugLogging = !g_debugLogging;
 				}
 			});
+			RegisterAction({
+				"ReaKontrol_Reconnect",
+				"ReaKontrol: Reconnect Komplete Kontrol Keyboard",
+				[]() {
+					for (IReaperControlSurface* surface : surfaces) {
+						static_cast<NiMidiSurface*>(surface)->Reconnect();
+					}
+				}
+			});
+			RegisterAction({
+				"ReaKontrol_Toggle_Capture",
+				"ReaKontrol: Toggle MIDI Session Capture",
+				toggleMidiCapture
+			});
 
 			return 1;
 		}
 		else {
 			// Unload
-			if (surface) {
+			for (IReaperControlSurface* surface : surfaces) {
 				delete surface;
-				surface = nullptr;
 			}
+			surfaces.clear();
 
 			// Unregister all actions
 			UnregisterAllActions();
 
+			// Finish a running capture
+			delete g_midiTrace;
+			g_midiTrace = nullptr;
+
 			return 0;
 		}
 	}
 }
 
-IReaperControlSurface* createNiMidiSurface()
+IReaperControlSurface* createNiMidiSurface(unsigned char surfaceIndex)
 {
-	return new NiMidiSurface();
+	return new NiMidiSurface(surfaceIndex);
 }
@@ -33,12 +33,26 @@
 #define REAPERAPI_WANT_TrackFX_GetCount
 #define REAPERAPI_WANT_TrackFX_GetFXName
 #define REAPERAPI_WANT_TrackFX_GetParamName
+#define REAPERAPI_WANT_TrackFX_GetNumParams
+#define REAPERAPI_WANT_TrackFX_GetParam
+#define REAPERAPI_WANT_TrackFX_GetParamNormalized
+#define REAPERAPI_WANT_TrackFX_SetParamNormalized
+#define REAPERAPI_WANT_TrackFX_GetFormattedParamValue
+#define REAPERAPI_WANT_TrackFX_GetParameterStepSizes
+#define REAPERAPI_WANT_TrackFX_GetFXGUID
+#define REAPERAPI_WANT_GetTrackNumSends
+#define REAPERAPI_WANT_GetSetTrackSendInfo
+#define REAPERAPI_WANT_CSurf_OnSendVolumeChange
+#define REAPERAPI_WANT_CSurf_OnSendPanChange
+#define REAPERAPI_WANT_CSurf_OnRecvVolumeChange
+#define REAPERAPI_WANT_CSurf_OnRecvPanChange
 #define REAPERAPI_WANT_CSurf_GoStart
 #define REAPERAPI_WANT_CSurf_OnStop
 #define REAPERAPI_WANT_CSurf_OnRecord
 #define REAPERAPI_WANT_Main_OnCommand
 #define REAPERAPI_WANT_CSurf_ScrubAmt
 #define REAPERAPI_WANT_GetSetMediaTrackInfo
+#define REAPERAPI_WANT_GetTrackGUID
 #define REAPERAPI_WANT_CSurf_SetTrackListChange
 #define REAPERAPI_WANT_CSurf_SetSurfaceVolume
 #define REAPERAPI_WANT_CSurf_SetSurfacePan
@@ -51,6 +65,7 @@
 #define REAPERAPI_WANT_CSurf_OnPanChange
 #define REAPERAPI_WANT_CSurf_OnMuteChange
 #define REAPERAPI_WANT_CSurf_OnSoloChange
+#define REAPERAPI_WANT_AnyTrackSolo
 #define REAPERAPI_WANT_GetPlayState
 #define REAPERAPI_WANT_GetSetRepeat
 #define REAPERAPI_WANT_GetGlobalAutomationOverride
@@ -65,6 +80,9 @@
 #define REAPERAPI_WANT_SetMixerScroll
 #define REAPERAPI_WANT_GetTrackStateChunk
 #define REAPERAPI_WANT_GetCursorPosition
+#define REAPERAPI_WANT_GetPlayPosition
+#define REAPERAPI_WANT_CountProjectMarkers
+#define REAPERAPI_WANT_EnumProjectMarkers3
 #define REAPERAPI_WANT_SetEditCurPos
 #define REAPERAPI_WANT_TimeMap_GetTimeSigAtTime
 #define REAPERAPI_WANT_GetSet_LoopTimeRange
@@ -73,6 +91,7 @@
 #define REAPERAPI_WANT_GetResourcePath
 #define REAPERAPI_WANT_file_exists
 #define REAPERAPI_WANT_NamedCommandLookup
+#define REAPERAPI_WANT_GetToggleCommandState
 #define REAPERAPI_WANT_GetSetObjectState2
 #define REAPERAPI_WANT_FreeHeapPtr
 #define REAPERAPI_WANT_TrackFX_GetNamedConfigParm
@@ -85,6 +104,12 @@
 #define REAPERAPI_WANT_CountTrackMediaItems
 #define REAPERAPI_WANT_GetMediaTrackInfo_Value
 #define REAPERAPI_WANT_GetTrackNumMediaItems
+#define REAPERAPI_WANT_GetTrackMediaItem
+#define REAPERAPI_WANT_GetMediaItemInfo_Value
+#define REAPERAPI_WANT_GetActiveTake
+#define REAPERAPI_WANT_GetTakeName
+#define REAPERAPI_WANT_GetProjectStateChangeCount
+#define REAPERAPI_WANT_format_timestr_pos
 
 // Reaper headers
 #include <reaper/reaper_plugin.h>
@@ -95,7 +120,8 @@
 
 class BaseSurface : public IReaperControlSurface {
 public:
-	BaseSurface();
+	// surfaceIndex: one per keyboard in the order the surfaces are created, tells them apart in MIDI session captures
+	explicit BaseSurface(unsigned char surfaceIndex = 0);
 	virtual ~BaseSurface();
 
 	virtual const char* GetConfigString() override { return ""; }
@@ -104,6 +130,7 @@ public:
 protected:
 	midi_Input* _midiIn = nullptr;
 	midi_Output* _midiOut = nullptr;
+	const unsigned char _surfaceIndex;
 
 	virtual void _onMidiEvent(MIDI_event_t* event) = 0;
 };
\ No newline at end of file
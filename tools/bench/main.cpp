@@ -0,0 +1,360 @@
+/*
+ * ReaKontrol
+ * reakontrol_bench: micro and macro benchmarks for the code running on every tick or every gesture
+ *
+ * Usage: reakontrol_bench [--out <file.json>] [--compare <baseline.json>] [--threshold <fraction>] [--filter <text>]
+ *
+ * Results are written as JSON (one result object per line). With --compare every result is checked against the
+ * baseline and the run fails (exit code 1) if any benchmark got slower by more than the threshold (default 0.10).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "MockHost.h"
+#include "KkSimulator.h"
+#include "NiMidiSurface.h"
+#include "CommandProcessor.h"
+#include "MidiSender.h"
+#include "ActionList.h"
+#include "Commands.h"
+#include "Constants.h"
+#include "Utils.h"
+#include "MidiDeviceCache.h"
+#include "SurfaceContext.h"
+
+namespace {
+    const int TRACK_COUNTS[] = { 10, 100, 1000, 5000 };
+    constexpr double TARGET_SECONDS = 0.05; // per sample
+    constexpr int SAMPLES = 5;
+
+    struct BenchResult {
+        std::string name;
+        int tracks = 0;
+        long long iterations = 0;
+        double nsPerOp = 0.0; // median of the samples
+        double minNsPerOp = 0.0;
+        double messagesPerOp = 0.0;
+    };
+
+    std::vector<BenchResult> results;
+    std::string filter;
+    long long messageCount = 0;
+
+    volatile unsigned char sink = 0; // keeps the compiler from dropping pure computations
+
+    void bench(const std::string& name, int tracks, const std::function<void()>& op) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+        // Calibrate: grow the batch until one batch takes a measurable amount of time
+        long long batch = 1;
+        for (;;) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (long long i = 0; i < batch; ++i) op();
+            double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (s >= TARGET_SECONDS / 10 || batch >= (1LL << 30)) {
+                batch = std::max(1LL, static_cast<long long>(batch * (TARGET_SECONDS / std::max(s, 1e-9))));
+                break;
+            }
+            batch *= 4;
+        }
+
+        std::vector<double> samples;
+        long long messagesBefore = messageCount;
+        for (int s = 0; s < SAMPLES; ++s) {
+            auto t0 = std::chrono::steady_clock::now();
+            for (long long i = 0; i < batch; ++i) op();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            samples.push_back(ns / batch);
+        }
+        std::sort(samples.begin(), samples.end());
+
+        BenchResult r;
+        r.name = name;
+        r.tracks = tracks;
+        r.iterations = batch * SAMPLES;
+        r.nsPerOp = samples[SAMPLES / 2];
+        r.minNsPerOp = samples.front();
+        r.messagesPerOp = static_cast<double>(messageCount - messagesBefore) / r.iterations;
+        results.push_back(r);
+        fprintf(stderr, "%-28s tracks=%-5d %12.1f ns/op %8.2f msg/op\n", name.c_str(), tracks, r.nsPerOp, r.messagesPerOp);
+    }
+
+    std::string toJson(const BenchResult& r) {
+        char buf[512];
+        snprintf(buf, sizeof(buf),
+            "{\"name\": \"%s\", \"tracks\": %d, \"iterations\": %lld, \"ns_per_op\": %.2f, \"min_ns_per_op\": %.2f, \"messages_per_op\": %.3f}",
+            r.name.c_str(), r.tracks, r.iterations, r.nsPerOp, r.minNsPerOp, r.messagesPerOp);
+        return buf;
+    }
+
+    bool jsonNumber(const std::string& line, const char* key, double& value) {
+        std::string k = std::string("\"") + key + "\": ";
+        size_t pos = line.find(k);
+        if (pos == std::string::npos) return false;
+        value = atof(line.c_str() + pos + k.size());
+        return true;
+    }
+
+    bool jsonString(const std::string& line, const char* key, std::string& value) {
+        std::string k = std::string("\"") + key + "\": \"";
+        size_t pos = line.find(k);
+        if (pos == std::string::npos) return false;
+        size_t end = line.find('"', pos + k.size());
+        value = line.substr(pos + k.size(), end - pos - k.size());
+        return true;
+    }
+
+    int compareWithBaseline(const char* path, double threshold) {
+        std::ifstream in(path);
+        if (!in) {
+            fprintf(stderr, "reakontrol_bench: cannot open baseline %s\n", path);
+            return 2;
+        }
+        int regressions = 0;
+        std::string line;
+        while (std::getline(in, line)) {
+            std::string name;
+            double tracks = 0.0;
+            double ns = 0.0;
+            if (!jsonString(line, "name", name) || !jsonNumber(line, "tracks", tracks) || !jsonNumber(line, "ns_per_op", ns)) continue;
+            for (const BenchResult& r : results) {
+                if (r.name != name || r.tracks != static_cast<int>(tracks) || ns <= 0.0) continue;
+                double change = (r.nsPerOp - ns) / ns;
+                if (change > threshold) {
+                    fprintf(stderr, "REGRESSION %s tracks=%d: %.1f -> %.1f ns/op (%+.1f%%)\n", name.c_str(), r.tracks, ns, r.nsPerOp, change * 100.0);
+                    ++regressions;
+                }
+            }
+        }
+        return regressions ? 1 : 0;
+    }
+
+    void setupProject(MockHost& host, int numTracks) {
+        host.setTrackCount(numTracks);
+        srand(42);
+        for (int id = 0; id <= numTracks; ++id) {
+            MockTrack* t = host.track(id);
+            t->peak[0] = (rand() % 1000) / 1000.0;
+            t->peak[1] = (rand() % 1000) / 1000.0;
+        }
+        host.trackListChanged();
+        host.tick();
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* outPath = nullptr;
+    const char* baseline = nullptr;
+    double threshold = 0.10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--out") outPath = argv[i + 1];
+        else if (arg == "--compare") baseline = argv[i + 1];
+        else if (arg == "--threshold") threshold = atof(argv[i + 1]);
+        else if (arg == "--filter") filter = argv[i + 1];
+        else {
+            fprintf(stderr, "Usage: reakontrol_bench [--out <file.json>] [--compare <baseline.json>] [--threshold <fraction>] [--filter <text>]\n");
+            return 2;
+        }
+    }
+
+    MockHost& host = MockHost::get();
+    host.setTrackCount(TRACK_COUNTS[0]);
+    if (!host.load()) {
+        fprintf(stderr, "reakontrol_bench: unable to load the plugin\n");
+        return 2;
+    }
+    {
+        KkSimulator kk(host.wire());
+        for (int i = 0; i < 1000 && !kk.display().connected; ++i) {
+            host.tick();
+        }
+        host.tick(2);
+    }
+    host.wire().setOutputListener([](const unsigned char*, int) { ++messageCount; });
+    NiMidiSurface* surface = static_cast<NiMidiSurface*>(host.surface());
+    MidiSender* sender = surface->GetMidiSender();
+    SurfaceContext& ctx = surface->GetContext();
+    CommandProcessor processor(ctx, *sender, surface);
+
+    // ---- Micro benchmarks, independent of project size ----
+    double volume = 0.0;
+    bench("volToChar_KkMk3", 0, [&volume]() {
+        volume = (volume >= 2.0) ? 0.0 : volume + 0.001;
+        sink = volToChar_KkMk3(volume);
+    });
+    bench("MidiSender::sendSysex", 0, [sender]() {
+        sender->sendSysex(CMD_TRACK_NAME, 0, 3, "Lead Vocals");
+    });
+    bench("MidiSender::sendCc", 0, [sender]() {
+        sender->sendCc(CMD_KNOB_VOLUME3, 64);
+    });
+    // Entering extended edit mode again while the action page is still on the display
+    showActionList(sender);
+    bench("showActionList (shown)", 0, [sender]() {
+        showActionList(sender);
+    });
+    bench("getMetronomeState", 0, []() {
+        sink = static_cast<unsigned char>(getMetronomeState());
+    });
+    bench("SurfaceContext::publish (unchanged)", 0, [&ctx]() {
+        ctx.publish();
+    });
+    bench("SurfaceContext::snapshot", 0, [&ctx]() {
+        sink = static_cast<unsigned char>(ctx.snapshot()->trackInFocus);
+    });
+    // Device scan while disconnected, in a studio with many MIDI ports
+    host.setOtherMidiPorts(32);
+    MidiDeviceCache devices;
+    bench("MidiDeviceCache::find (32 ports)", 0, [&devices]() {
+        sink = static_cast<unsigned char>(devices.find().size());
+    });
+    // Liveness check of the connected keyboard, every LIVENESS_MS
+    KkMidiDevices connected = devices.find().empty() ? KkMidiDevices() : devices.find().front();
+    bench("MidiDeviceCache::isListed (32 ports)", 0, [&connected]() {
+        sink = static_cast<unsigned char>(MidiDeviceCache::isListed(connected));
+    });
+    host.setOtherMidiPorts(0);
+    // FX parameter mode on a synth with 500 parameters: page through all of them and back
+    host.addFx(1, "Synth", 500);
+    ctx.state.trackInFocus = 1;
+    ctx.setExtEditMode(EXT_EDIT_FX);
+    fxParamUpdate(ctx, sender, true);
+    int fxStep = 0;
+    bench("FX parameter page turn", 0, [&processor, &fxStep]() {
+        processor.Handle(CMD_NAV_BANKS, ((fxStep++ / 63) & 1) ? 127 : 1, EVENT_CLICK_SINGLE);
+    });
+    bench("fxParamUpdate (unchanged)", 0, [&ctx, sender]() {
+        fxParamUpdate(ctx, sender);
+    });
+    // Routing page of a track sending to 8 buses: switching between its sends and receives only reads the cached routes
+    for (int dest = 2; dest <= 9; ++dest) host.addSend(1, dest);
+    ctx.setExtEditMode(EXT_EDIT_SENDS);
+    routePageUpdate(ctx, sender, true);
+    int routeStep = 0;
+    bench("routing page switch", 0, [&processor, &routeStep]() {
+        processor.Handle(CMD_NAV_CLIPS, (routeStep++ & 1) ? 127 : 1, EVENT_CLICK_SINGLE);
+    });
+    bench("routePageUpdate (unchanged)", 0, [&ctx, sender]() {
+        routePageUpdate(ctx, sender);
+    });
+    host.track(1)->sends.clear();
+    ctx.setExtEditMode(EXT_EDIT_OFF);
+    // Marker navigation in a project with 2000 markers: a binary search from the cursor, the markers are only read again
+    // after a marker change
+    for (int i = 0; i < 2000; ++i) host.addMarker(2.0 * i, -1.0, "");
+    host.project().cursor = 2000.0;
+    int markerStep = 0;
+    bench("marker navigation (2000 markers)", 0, [&processor, &markerStep]() {
+        processor.Handle(CMD_NAV_CLIPS, ((markerStep++ / 100) & 1) ? 127 : 1, EVENT_CLICK_SINGLE);
+    });
+    bench("MarkerIndex rebuild (2000 markers)", 0, [&ctx]() {
+        ctx.markers.invalidate();
+        sink = static_cast<unsigned char>(ctx.markers.size());
+    });
+    host.project().markers.clear();
+    ctx.markers.invalidate();
+    // Item navigation (extended edit mode) on a track with 500 items, and reading them again after any undo point
+    for (int i = 0; i < 500; ++i) host.addItem(1, 4.0 * i, "Take " + std::to_string(i + 1));
+    ctx.state.trackInFocus = 1;
+    host.project().cursor = 1000.0;
+    ctx.setExtEditMode(EXT_EDIT_ON);
+    int itemStep = 0;
+    bench("item navigation (500 items)", 0, [&processor, &itemStep]() {
+        processor.Handle(CMD_NAV_CLIPS, ((itemStep++ / 100) & 1) ? 127 : 1, EVENT_CLICK_SINGLE);
+    });
+    ctx.setExtEditMode(EXT_EDIT_OFF);
+    MediaTrack* itemTrack = CSurf_TrackFromID(1, false);
+    bench("ItemIndex re-read (500 items)", 0, [&ctx, itemTrack]() {
+        ctx.items.invalidate();
+        sink = static_cast<unsigned char>(ctx.items.size(itemTrack));
+    });
+    host.track(1)->items.clear();
+    ctx.items.invalidate();
+
+    // ---- Per project size ----
+    for (int numTracks : TRACK_COUNTS) {
+        setupProject(host, numTracks);
+
+        bench("peakMixerUpdate", numTracks, [&ctx, sender]() {
+            peakMixerUpdate(ctx, sender);
+        });
+        bench("allMixerUpdate", numTracks, [&ctx, sender]() {
+            allMixerUpdate(ctx, sender);
+        });
+        bench("CommandProcessor::Handle", numTracks, [&processor]() {
+            processor.Handle(CMD_KNOB_VOLUME1, 1, EVENT_CLICK_SINGLE);
+            processor.Handle(CMD_KNOB_VOLUME1, 127, EVENT_CLICK_SINGLE);
+        });
+        int step = 0;
+        bench("handleNavTracks", numTracks, [&processor, &step]() {
+            // Walk back and forth around the middle of the project
+            processor.Handle(CMD_NAV_TRACKS, (step++ & 1) ? 127 : 1, EVENT_CLICK_SINGLE);
+        });
+        double automation = 0.5;
+        bench("volume automation pass", numTracks, [&host, &automation]() {
+            // Tiny steps as from an envelope, the display text only changes every few calls
+            automation = (automation >= 0.51) ? 0.5 : automation + 0.00001;
+            host.setVolume(1, automation);
+        });
+        int selected = 0;
+        bench("selection change", numTracks, [&host, &selected, numTracks]() {
+            // REAPER reports every track to SetSurfaceSelected on any selection change
+            selected = (selected + 1) % numTracks;
+            host.selectTrack(selected);
+            host.tick();
+        });
+        // What SetTrackListChange costs on the next lookup: one pass over the project
+        bench("BankLayout rebuild", numTracks, [&ctx]() {
+            ctx.bank.invalidate();
+            sink = static_cast<unsigned char>(ctx.bank.size());
+        });
+        // Jump to track mode: entering it after a track list change, then every letter spelled with the 4D encoder
+        bench("TrackSearchIndex build", numTracks, [&ctx]() {
+            ctx.trackSearch.invalidate();
+            ctx.trackSearch.build(ctx.trackNames);
+        });
+        bench("TrackSearchIndex::find", numTracks, [&ctx]() {
+            // "Track 1" matches more than a fifth of the project, more than a real name would
+            ctx.trackSearch.find("track 1", ctx.searchResults);
+            sink = static_cast<unsigned char>(ctx.trackSearch.nextChars("track 1").size() + ctx.searchResults.size());
+        });
+        bench("Run (idle tick)", numTracks, [&host]() {
+            host.tick();
+        });
+        // A single click is only handled once DOUBLE_CLICK_MS passed without a second click, the click cooldown has
+        // to pass before the next gesture is accepted. Each tick advances the host's virtual clock by msPerTick.
+        int gestureTicks = (DOUBLE_CLICK_MS + CLICK_COOLDOWN_MS) / host.msPerTick + 2;
+        bench("single click gesture", numTracks, [&host, gestureTicks]() {
+            host.wire().injectCc(MIDI_CC, CMD_STOP, 1);
+            host.tick(gestureTicks);
+        });
+    }
+
+    std::ostringstream json;
+    json << "{\"suite\": \"reakontrol_bench\", \"version\": 1, \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        json << "  " << toJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "]}\n";
+
+    if (outPath) {
+        std::ofstream out(outPath);
+        out << json.str();
+    }
+    else {
+        fputs(json.str().c_str(), stdout);
+    }
+
+    host.unload();
+    return baseline ? compareWithBaseline(baseline, threshold) : 0;
+}
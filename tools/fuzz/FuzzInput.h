@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encoding of a MIDI session as fuzzer input, shared by the harness and kkcorpus. The input is a sequence of
+// control bytes c, each optionally followed by a raw MIDI message:
+//   bit 3 clear: a message of ((c & 3) + 1) raw bytes follows, afterwards ((c >> 4) & 3) ticks are run
+//   bit 3 set:   no message, ((c >> 4) + 1) ticks are run (lets the click timeouts expire)
+// All remaining bits are ignored, so every byte string decodes to a valid session.
+
+constexpr uint8_t FUZZ_TICKS_ONLY = 0x08;
+constexpr int FUZZ_MAX_MESSAGE = 4;
+constexpr int FUZZ_MAX_MESSAGE_TICKS = 3;
+constexpr int FUZZ_MAX_TICKS = 16;
+
+struct FuzzStep {
+    const uint8_t* msg; // nullptr for a tick-only step
+    int size;
+    int ticks;
+};
+
+// Decodes the next step, returns false at the end of the input
+inline bool nextFuzzStep(const uint8_t*& data, size_t& size, FuzzStep& step) {
+    if (size == 0) return false;
+    uint8_t c = *data++;
+    --size;
+    if (c & FUZZ_TICKS_ONLY) {
+        step.msg = nullptr;
+        step.size = 0;
+        step.ticks = (c >> 4) + 1;
+        return true;
+    }
+    size_t len = (c & 3) + 1;
+    if (len > size) len = size;
+    step.msg = len ? data : nullptr;
+    step.size = static_cast<int>(len);
+    step.ticks = (c >> 4) & 3;
+    data += len;
+    size -= len;
+    return true;
+}
+
+// Appends one MIDI message (longer messages are cut to FUZZ_MAX_MESSAGE bytes) followed by up to
+// FUZZ_MAX_MESSAGE_TICKS ticks, returns the number of ticks that could not be encoded
+inline int encodeFuzzMessage(std::vector<uint8_t>& out, const uint8_t* msg, size_t size, int ticks) {
+    if (size == 0) return ticks;
+    size_t len = size > FUZZ_MAX_MESSAGE ? FUZZ_MAX_MESSAGE : size;
+    int t = ticks > FUZZ_MAX_MESSAGE_TICKS ? FUZZ_MAX_MESSAGE_TICKS : ticks;
+    out.push_back(static_cast<uint8_t>((len - 1) | (t << 4)));
+    out.insert(out.end(), msg, msg + len);
+    return ticks - t;
+}
+
+// Appends tick-only steps
+inline void encodeFuzzTicks(std::vector<uint8_t>& out, int ticks) {
+    while (ticks > 0) {
+        int t = ticks > FUZZ_MAX_TICKS ? FUZZ_MAX_TICKS : ticks;
+        out.push_back(static_cast<uint8_t>(FUZZ_TICKS_ONLY | ((t - 1) << 4)));
+        ticks -= t;
+    }
+}
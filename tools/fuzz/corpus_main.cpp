@@ -0,0 +1,151 @@
+/*
+ * ReaKontrol
+ * kkcorpus: converts captured MIDI sessions (see "ReaKontrol: Toggle MIDI Session Capture") into seed inputs for
+ * fuzz_midi_input, so fuzzing starts from real gestures instead of random bytes.
+ *
+ * Usage: kkcorpus <outdir> <trace>... [--events <n>]
+ *
+ * Every trace is cut into inputs of at most n inbound messages (default 64). Idle gaps between messages are kept
+ * up to MAX_IDLE_TICKS, longer gaps don't change anything the surface does with the input. A capture with several
+ * keyboards is converted per surface, their inputs are named <trace>-s<surface>-<n>.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MidiTrace.h"
+#include "FuzzInput.h"
+
+namespace {
+    constexpr int MAX_IDLE_TICKS = 64;
+
+    std::string baseName(const std::string& path) {
+        size_t slash = path.find_last_of("/\\");
+        std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        size_t dot = name.rfind('.');
+        return (dot == std::string::npos) ? name : name.substr(0, dot);
+    }
+
+    bool writeInput(const std::string& outDir, const std::string& name, int index, const std::vector<uint8_t>& input) {
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), "-%04d", index);
+        std::string path = outDir + "/" + name + suffix;
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(input.data()), input.size());
+        return static_cast<bool>(out);
+    }
+
+    // Records of one surface, returns the number of inputs written
+    int convertSurface(const std::vector<MidiTraceRecord>& records, const std::string& outDir, const std::string& name,
+        int eventsPerInput) {
+        std::vector<uint8_t> input;
+        int events = 0;
+        int written = 0;
+        int idleTicks = 0;
+
+        // Inbound messages belong to the TICK record preceding them (they are read in that Run() call)
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (records[i].type != TRACE_TICK) continue;
+            size_t first = i + 1;
+            size_t end = first;
+            while (end < records.size() && records[end].type != TRACE_TICK) ++end;
+
+            bool anyInbound = false;
+            for (size_t j = first; j < end; ++j) {
+                if (records[j].type != TRACE_IN || records[j].msg.empty()) continue;
+                if (!anyInbound) {
+                    encodeFuzzTicks(input, idleTicks > MAX_IDLE_TICKS ? MAX_IDLE_TICKS : idleTicks);
+                    idleTicks = 0;
+                    anyInbound = true;
+                }
+                // All messages of one tick are injected before it runs
+                bool lastOfTick = true;
+                for (size_t k = j + 1; k < end; ++k) {
+                    if (records[k].type == TRACE_IN && !records[k].msg.empty()) {
+                        lastOfTick = false;
+                        break;
+                    }
+                }
+                const std::vector<unsigned char>& msg = records[j].msg;
+                encodeFuzzMessage(input, msg.data(), msg.size(), lastOfTick ? 1 : 0);
+                ++events;
+            }
+            if (!anyInbound) {
+                ++idleTicks;
+            }
+            if (events >= eventsPerInput) {
+                if (!writeInput(outDir, name, written, input)) return written;
+                ++written;
+                input.clear();
+                events = 0;
+                idleTicks = 0;
+            }
+            i = end - 1;
+        }
+        if (events > 0 && writeInput(outDir, name, written, input)) {
+            ++written;
+        }
+        return written;
+    }
+
+    // Returns the number of inputs written, -1 if the trace can't be read
+    int convert(const std::string& tracePath, const std::string& outDir, int eventsPerInput) {
+        std::vector<MidiTraceRecord> records;
+        if (!readMidiTrace(tracePath, records)) {
+            return -1;
+        }
+        int numSurfaces = 0;
+        for (const MidiTraceRecord& record : records) {
+            numSurfaces = std::max(numSurfaces, record.surface + 1);
+        }
+        std::string name = baseName(tracePath);
+        if (numSurfaces <= 1) {
+            return convertSurface(records, outDir, name, eventsPerInput);
+        }
+        int written = 0;
+        for (int surface = 0; surface < numSurfaces; ++surface) {
+            std::vector<MidiTraceRecord> own = records;
+            filterMidiTrace(own, static_cast<unsigned char>(surface));
+            written += convertSurface(own, outDir, name + "-s" + std::to_string(surface), eventsPerInput);
+        }
+        return written;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> traces;
+    std::string outDir;
+    int eventsPerInput = 64;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--events" && i + 1 < argc) {
+            eventsPerInput = atoi(argv[++i]);
+        }
+        else if (outDir.empty()) {
+            outDir = arg;
+        }
+        else {
+            traces.push_back(arg);
+        }
+    }
+    if (outDir.empty() || traces.empty() || eventsPerInput < 1) {
+        fprintf(stderr, "Usage: kkcorpus <outdir> <trace>... [--events <n>]\n");
+        return 2;
+    }
+
+    int total = 0;
+    for (const std::string& trace : traces) {
+        int written = convert(trace, outDir, eventsPerInput);
+        if (written < 0) {
+            fprintf(stderr, "kkcorpus: cannot read trace %s\n", trace.c_str());
+            return 2;
+        }
+        fprintf(stderr, "%s: %d inputs\n", trace.c_str(), written);
+        total += written;
+    }
+    fprintf(stderr, "%d inputs written to %s\n", total, outDir.c_str());
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * ReaKontrol
+ * fuzz_midi_input: libFuzzer target feeding arbitrary MIDI input through BaseSurface::Run() and the command
+ * dispatch of a connected NiMidiSurface running against the mock host.
+ *
+ * The input is decoded as described in FuzzInput.h. The plugin stays loaded and connected across inputs (a fresh
+ * load and handshake per input would cost more than the input itself), the mock project and the surface mode are
+ * reset before every input so that findings reproduce from the crashing input alone in almost all cases.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include "MockHost.h"
+#include "KkSimulator.h"
+#include "FuzzInput.h"
+#include "Constants.h"
+#include "NiMidiSurface.h"
+
+namespace {
+    constexpr int FUZZ_TRACKS = 20; // more than two banks
+
+    bool connected = false;
+
+    void resetProject(MockHost& host) {
+        MockProject& proj = host.project();
+        proj = MockProject();
+        host.setTrackCount(FUZZ_TRACKS);
+        host.trackListChanged();
+        host.commandLog.clear();
+        host.messageBoxes.clear();
+        host.console.clear();
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv) {
+    MockHost& host = MockHost::get();
+    host.setTrackCount(FUZZ_TRACKS);
+    if (!host.load()) {
+        fprintf(stderr, "fuzz_midi_input: unable to load the plugin\n");
+        abort();
+    }
+    KkSimulator kk(host.wire());
+    for (int i = 0; i < 1000 && !kk.display().connected; ++i) {
+        host.tick();
+    }
+    host.tick(2);
+    connected = kk.display().connected;
+    if (!connected) {
+        fprintf(stderr, "fuzz_midi_input: handshake with the virtual keyboard failed\n");
+        abort();
+    }
+    // Nobody listens from here on, outbound messages are only checked for memory safety
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    MockHost& host = MockHost::get();
+    resetProject(host);
+    static_cast<NiMidiSurface*>(host.surface())->GetContext().setExtEditMode(EXT_EDIT_OFF);
+
+    FuzzStep step;
+    while (nextFuzzStep(data, size, step)) {
+        if (step.msg) {
+            host.wire().inject(step.msg, step.size);
+        }
+        host.tick(step.ticks);
+    }
+    // Let pending clicks fire and the click cooldown pass so the next input starts from a quiet surface
+    host.tick((DOUBLE_CLICK_MS + CLICK_COOLDOWN_MS) / host.msPerTick + 2);
+    return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * ReaKontrol
+ * Minimal replacement for the libFuzzer driver: runs the fuzz target once for every file given on the command line.
+ * Used to reproduce and debug findings with compilers that don't ship libFuzzer (GCC, older MSVC).
+ *
+ * Usage: fuzz_midi_input <input>...
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <input>...\n", argv[0]);
+        return 2;
+    }
+    LLVMFuzzerInitialize(&argc, &argv);
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream in(argv[i], std::ios::binary);
+        if (!in) {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 2;
+        }
+        std::vector<uint8_t> input((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        fprintf(stderr, "Running %s (%zu bytes)\n", argv[i], input.size());
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "KkSimulator.h"
+#include "MockMidi.h"
+#include "Commands.h"
+#include <cstring>
+#include <sstream>
+
+KkSimulator::KkSimulator(MockMidiWire& wire, int protocolVersion)
+    : wire(wire), protocolVersion(protocolVersion) {
+    wire.setOutputListener([this](const unsigned char* msg, int size) {
+        onHostMessage(msg, size);
+    });
+    wire.setPlugListener([this](bool plugged) {
+        if (!plugged) {
+            state = KkDisplayState(); // powered off, the display is gone
+        }
+    });
+}
+
+KkSimulator::~KkSimulator() {
+    wire.setOutputListener(nullptr);
+    wire.setPlugListener(nullptr);
+}
+
+void KkSimulator::pressButton(unsigned char command, unsigned char value) {
+    wire.injectCc(MIDI_CC, command, value);
+}
+
+void KkSimulator::turnEncoder(unsigned char command, int delta) {
+    if (delta < -64) delta = -64;
+    if (delta > 63) delta = 63;
+    wire.injectCc(MIDI_CC, command, static_cast<unsigned char>(delta & 0x7F));
+}
+
+void KkSimulator::pressSlotButton(unsigned char command, int slot) {
+    wire.injectCc(MIDI_CC, command, static_cast<unsigned char>(slot & 0x7F));
+}
+
+void KkSimulator::onHostMessage(const unsigned char* msg, int size) {
+    msgCounts.bytes += size;
+    if (size >= 3 && msg[0] == MIDI_CC) {
+        msgCounts.cc++;
+        msgCounts.perCommand[msg[1]]++;
+        decodeCc(msg[1], msg[2]);
+    }
+    else if (size >= static_cast<int>(sizeof(MIDI_SYSEX_BEGIN)) + 4 &&
+        !memcmp(msg, MIDI_SYSEX_BEGIN, sizeof(MIDI_SYSEX_BEGIN)) && msg[size - 1] == MIDI_SYSEX_END) {
+        msgCounts.sysex++;
+        msgCounts.perCommand[msg[sizeof(MIDI_SYSEX_BEGIN)]]++;
+        decodeSysex(msg, size);
+    }
+    else {
+        msgCounts.unknown++;
+    }
+}
+
+void KkSimulator::decodeCc(unsigned char command, unsigned char value) {
+    if (command == CMD_HELLO) {
+        // NIHIA acknowledges the handshake with its protocol version
+        if (answerHello) {
+            state.connected = true;
+            wire.injectCc(MIDI_CC, CMD_HELLO, static_cast<unsigned char>(protocolVersion));
+        }
+        return;
+    }
+    if (command == CMD_GOODBYE) {
+        state = KkDisplayState();
+        return;
+    }
+    if (command >= CMD_KNOB_VOLUME0 && command <= CMD_KNOB_VOLUME7) {
+        state.slots[command - CMD_KNOB_VOLUME0].volumeKnob = value;
+        return;
+    }
+    if (command >= CMD_KNOB_PAN0 && command <= CMD_KNOB_PAN7) {
+        state.slots[command - CMD_KNOB_PAN0].panKnob = value;
+        return;
+    }
+    switch (command) {
+    case CMD_SEL_TRACK_AVAILABLE: state.selTrackAvailable = value != 0; break;
+    case CMD_TOGGLE_SEL_TRACK_MUTE: state.selTrackMuted = value != 0; break;
+    case CMD_TOGGLE_SEL_TRACK_SOLO: state.selTrackSoloed = value != 0; break;
+    case CMD_SEL_TRACK_MUTED_BY_SOLO: state.selTrackMutedBySolo = value != 0; break;
+    default: state.leds[command] = value; break;
+    }
+}
+
+void KkSimulator::decodeSysex(const unsigned char* msg, int size) {
+    size_t pos = sizeof(MIDI_SYSEX_BEGIN);
+    unsigned char command = msg[pos];
+    unsigned char value = msg[pos + 1];
+    unsigned char track = msg[pos + 2];
+    const char* info = reinterpret_cast<const char*>(msg + pos + 3);
+    size_t infoLength = size - (pos + 3) - 1;
+    // Text fields end at the first NUL, just like NIHIA treats them
+    std::string text(info, strnlen(info, infoLength));
+
+    if (command == CMD_TRACK_VU) {
+        // Meters of the whole bank: 2 chars per slot, a 0 char ends the list
+        for (int i = 0; i < BANK_NUM_TRACKS * 2; ++i) {
+            unsigned char level = (i < static_cast<int>(text.size())) ? static_cast<unsigned char>(text[i]) : 0;
+            state.slots[i / 2].meter[i % 2] = level;
+        }
+        return;
+    }
+    if (track >= BANK_NUM_TRACKS) {
+        msgCounts.unknown++;
+        return;
+    }
+
+    KkSlot& slot = state.slots[track];
+    switch (command) {
+    case CMD_TRACK_AVAIL: slot.available = value; break;
+    case CMD_TRACK_SELECTED: slot.selected = value != 0; break;
+    case CMD_TRACK_MUTED: slot.muted = value != 0; break;
+    case CMD_TRACK_SOLOED: slot.soloed = value != 0; break;
+    case CMD_TRACK_ARMED: slot.armed = value != 0; break;
+    case CMD_TRACK_VOLUME_TEXT: slot.volumeText = text; break;
+    case CMD_TRACK_PAN_TEXT: slot.panText = text; break;
+    case CMD_TRACK_NAME: slot.name = text; break;
+    case CMD_TRACK_MUTED_BY_SOLO: slot.mutedBySolo = value != 0; break;
+    // Selected track commands are sent as SysEx too (NIHIA v1.8.7), always with track 0
+    case CMD_TOGGLE_SEL_TRACK_MUTE: state.selTrackMuted = value != 0; break;
+    case CMD_TOGGLE_SEL_TRACK_SOLO: state.selTrackSoloed = value != 0; break;
+    case CMD_SEL_TRACK_AVAILABLE: state.selTrackAvailable = value != 0; break;
+    case CMD_SEL_TRACK_MUTED_BY_SOLO: state.selTrackMutedBySolo = value != 0; break;
+    default: msgCounts.unknown++; break;
+    }
+}
+
+std::string KkSimulator::dump() const {
+    // Stable text rendering of the display model, meant to be diffed against a known-good capture
+    std::ostringstream out;
+    out << "connected " << (state.connected ? 1 : 0) << "\n";
+    for (int i = 0; i < BANK_NUM_TRACKS; ++i) {
+        const KkSlot& s = state.slots[i];
+        out << "slot " << i
+            << " avail=" << static_cast<int>(s.available)
+            << " name='" << s.name << "'"
+            << " vol='" << s.volumeText << "'/" << static_cast<int>(s.volumeKnob)
+            << " pan='" << s.panText << "'/" << static_cast<int>(s.panKnob)
+            << " sel=" << s.selected
+            << " mute=" << s.muted
+            << " solo=" << s.soloed
+            << " mbs=" << s.mutedBySolo
+            << " arm=" << s.armed
+            << "\n";
+    }
+    out << "seltrack avail=" << state.selTrackAvailable
+        << " mute=" << state.selTrackMuted
+        << " solo=" << state.selTrackSoloed
+        << " mbs=" << state.selTrackMutedBySolo << "\n";
+    for (const auto& led : state.leds) {
+        out << "led " << getCommandName(led.first) << "=" << static_cast<int>(led.second) << "\n";
+    }
+    return out.str();
+}
+
+std::string KkSimulator::dumpCounts() const {
+    std::ostringstream out;
+    out << "messages cc=" << msgCounts.cc << " sysex=" << msgCounts.sysex
+        << " bytes=" << msgCounts.bytes << " unknown=" << msgCounts.unknown << "\n";
+    for (const auto& c : msgCounts.perCommand) {
+        out << "  " << getCommandName(c.first) << " " << c.second << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include "Constants.h"
+
+class MockMidiWire;
+
+// One of the 8 mixer slots of the Mk3 display as NIHIA would render it
+struct KkSlot {
+    unsigned char available = 0; // track type, 0 = not available
+    std::string name;
+    std::string volumeText;
+    std::string panText;
+    bool selected = false;
+    bool muted = false;
+    bool soloed = false;
+    bool mutedBySolo = false;
+    bool armed = false;
+    unsigned char volumeKnob = 0;
+    unsigned char panKnob = 0;
+    unsigned char meter[2] = { 0, 0 };
+};
+
+struct KkDisplayState {
+    KkSlot slots[BANK_NUM_TRACKS];
+    std::map<unsigned char, unsigned char> leds; // last CC value per button / LED command
+    bool selTrackAvailable = false;
+    bool selTrackMuted = false;
+    bool selTrackSoloed = false;
+    bool selTrackMutedBySolo = false;
+    bool connected = false;
+};
+
+struct KkMessageCounts {
+    int cc = 0;
+    int sysex = 0;
+    int bytes = 0;
+    int unknown = 0;
+    std::map<unsigned char, int> perCommand;
+};
+
+// Virtual Komplete Kontrol Mk3 keyboard plus NIHIA: answers the handshake, decodes everything the plugin sends
+// into a display model and injects button / encoder input.
+class KkSimulator {
+public:
+    explicit KkSimulator(MockMidiWire& wire, int protocolVersion = 4);
+    ~KkSimulator();
+
+    void setProtocolVersion(int version) { protocolVersion = version; }
+    void setAnswerHello(bool answer) { answerHello = answer; }
+
+    // ---- Input ----
+    void pressButton(unsigned char command, unsigned char value = 1);
+    void turnEncoder(unsigned char command, int delta); // delta is sent as signed 7 bit value
+    void pressSlotButton(unsigned char command, int slot); // e.g. CMD_TRACK_SELECTED / CMD_TRACK_MUTED for slot 0-7
+
+    // ---- Output ----
+    const KkDisplayState& display() const { return state; }
+    const KkMessageCounts& counts() const { return msgCounts; }
+    void resetCounts() { msgCounts = KkMessageCounts(); }
+    std::string dump() const;
+    std::string dumpCounts() const;
+
+private:
+    void onHostMessage(const unsigned char* msg, int size);
+    void decodeCc(unsigned char command, unsigned char value);
+    void decodeSysex(const unsigned char* msg, int size);
+
+    MockMidiWire& wire;
+    int protocolVersion;
+    bool answerHello = true;
+    KkDisplayState state;
+    KkMessageCounts msgCounts;
+};
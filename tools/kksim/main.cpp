@@ -0,0 +1,191 @@
+/*
+ * ReaKontrol
+ * kksim: runs a scripted session of the virtual Komplete Kontrol Mk3 against the mock host
+ *
+ * Usage: kksim <script> [--golden <file>]
+ *
+ * Every run gets a fresh resource directory in the system's temp directory, so reakontrol.ini starts out as the
+ * plugin's default and whatever a script writes into it doesn't leak into the next run.
+ *
+ * Script commands (one per line, '#' starts a comment):
+ *   tracks <n>              project with n tracks (plus master)
+ *   protocol <v>            protocol version NIHIA answers CMD_HELLO with
+ *   hello <0|1>             whether NIHIA answers CMD_HELLO at all
+ *   load / unload           load or unload the plugin
+ *   plug / unplug           connect or disconnect the keyboard's MIDI ports
+ *   tick [n]                run n control surface ticks (default 1), each advances the virtual clock by 33 ms
+ *   press <cmd> [value]     button press, e.g. "press PLAY"
+ *   turn <cmd> <delta>      encoder / knob turn, e.g. "turn NAV_TRACKS 1"
+ *   slot <cmd> <slot>       slot button, e.g. "slot TRACK_MUTED 3"
+ *   select <id>             select a track from within REAPER
+ *   volume <id> <value>     set volume from within REAPER (linear)
+ *   pan <id> <value>        set pan from within REAPER (-1..1)
+ *   mute <id> <0|1>, solo <id> <0|1>, arm <id> <0|1>
+ *   name <id> <text>        rename a track (rest of the line, reported like a selection change)
+ *   fx <id> <name> <n>      add an FX with n parameters to a track
+ *   send <id> <dest>        add a send from a track to another one
+ *   marker <pos> [name]     add a marker at pos seconds
+ *   region <s> <e> [name]   add a region from s to e seconds
+ *   item <id> <pos> [name]  add an item at pos seconds to a track (take name, none: item without take)
+ *   hide <id> <0|1>         hide a track in the mixer (reported as a track list change)
+ *   folder <id> <depth> <c> set a track's I_FOLDERDEPTH and I_FOLDERCOMPACT (reported as a track list change)
+ *   action <idstr>          run an action registered by the plugin, e.g. "action ReaKontrol_Toggle_Capture"
+ *   ini <section> <key> <v> write a value into reakontrol.ini, e.g. "ini reakontrol_actions action_0_ID 40364"
+ *                           (rest of the line; before "load", the plugin reads the file when it connects)
+ *   reset-counts / counts   reset / print message counters
+ *   dump                    print the display model
+ *   cursor                  print the edit cursor position (seconds)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include "MockHost.h"
+#include "KkSimulator.h"
+#include "Commands.h"
+#include "ActionList.h"
+#include "reaKontrol.h"
+
+namespace {
+    int commandFromName(const std::string& name) {
+        std::string full = (name.compare(0, 4, "CMD_") == 0) ? name : "CMD_" + name;
+        for (int cmd = 0; cmd < 128; ++cmd) {
+            if (full == getCommandName(static_cast<unsigned char>(cmd))) {
+                return cmd;
+            }
+        }
+        char* end = nullptr;
+        long value = strtol(name.c_str(), &end, 0);
+        return (end && *end == '\0' && value >= 0 && value < 128) ? static_cast<int>(value) : -1;
+    }
+
+    bool runScript(std::istream& script, std::ostream& out) {
+        MockHost& host = MockHost::get();
+        KkSimulator kk(host.wire());
+        std::string line;
+        int lineNo = 0;
+
+        while (std::getline(script, line)) {
+            ++lineNo;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos) line.erase(hash);
+            std::istringstream args(line);
+            std::string op;
+            if (!(args >> op)) continue;
+
+            std::string name, key, value;
+            int a = 0, b = 0, c = 0;
+            double v = 0.0, w = 0.0;
+            bool ok = true;
+
+            if (op == "tracks" && (args >> a)) host.setTrackCount(a);
+            else if (op == "protocol" && (args >> a)) kk.setProtocolVersion(a);
+            else if (op == "hello" && (args >> a)) kk.setAnswerHello(a != 0);
+            else if (op == "load") ok = host.load();
+            else if (op == "unload") host.unload();
+            else if (op == "plug") host.setDevicePresent(true);
+            else if (op == "unplug") host.setDevicePresent(false);
+            else if (op == "tick") host.tick((args >> a) ? a : 1);
+            else if (op == "press" && (args >> name)) {
+                int cmd = commandFromName(name);
+                ok = cmd >= 0;
+                if (ok) kk.pressButton(static_cast<unsigned char>(cmd), (args >> a) ? static_cast<unsigned char>(a) : 1);
+            }
+            else if (op == "turn" && (args >> name >> a)) {
+                int cmd = commandFromName(name);
+                ok = cmd >= 0;
+                if (ok) kk.turnEncoder(static_cast<unsigned char>(cmd), a);
+            }
+            else if (op == "slot" && (args >> name >> a)) {
+                int cmd = commandFromName(name);
+                ok = cmd >= 0;
+                if (ok) kk.pressSlotButton(static_cast<unsigned char>(cmd), a);
+            }
+            else if (op == "select" && (args >> a)) host.selectTrack(a);
+            else if (op == "volume" && (args >> a >> v)) host.setVolume(a, v);
+            else if (op == "pan" && (args >> a >> v)) host.setPan(a, v);
+            else if (op == "mute" && (args >> a >> v)) host.setMute(a, v != 0.0);
+            else if (op == "solo" && (args >> a >> v)) host.setSolo(a, v != 0.0 ? 1 : 0);
+            else if (op == "arm" && (args >> a >> v)) host.setRecArm(a, v != 0.0);
+            else if (op == "name" && (args >> a) && std::getline(args >> std::ws, name)) host.setTrackName(a, name);
+            else if (op == "fx" && (args >> a >> name >> b)) host.addFx(a, name, b);
+            else if (op == "send" && (args >> a >> b)) host.addSend(a, b);
+            else if (op == "marker" && (args >> v)) {
+                std::getline(args >> std::ws, name);
+                host.addMarker(v, -1.0, name);
+            }
+            else if (op == "region" && (args >> v >> w)) {
+                std::getline(args >> std::ws, name);
+                host.addMarker(v, w, name);
+            }
+            else if (op == "item" && (args >> a >> v)) {
+                std::getline(args >> std::ws, name);
+                host.addItem(a, v, name);
+            }
+            else if (op == "hide" && (args >> a >> b)) host.setShownInMixer(a, b == 0);
+            else if (op == "folder" && (args >> a >> b >> c)) host.setFolder(a, b, c);
+            else if (op == "action" && (args >> name)) ok = host.runAction(name);
+            else if (op == "ini" && (args >> name >> key) && std::getline(args >> std::ws, value)) {
+                ok = WritePrivateProfileString(name.c_str(), key.c_str(), value.c_str(),
+                    configFilePath(host.resourcePath).c_str()) != 0;
+            }
+            else if (op == "reset-counts") kk.resetCounts();
+            else if (op == "counts") out << kk.dumpCounts();
+            else if (op == "dump") out << kk.dump();
+            else if (op == "cursor") out << "cursor " << host.project().cursor << "\n";
+            else ok = false;
+
+            if (!ok) {
+                std::cerr << "kksim: line " << lineNo << ": cannot execute '" << line << "'\n";
+                return false;
+            }
+        }
+        host.unload();
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: kksim <script> [--golden <file>]\n";
+        return 2;
+    }
+    std::ifstream script(argv[1]);
+    if (!script) {
+        std::cerr << "kksim: cannot open " << argv[1] << "\n";
+        return 2;
+    }
+    const char* golden = (argc >= 4 && std::string(argv[2]) == "--golden") ? argv[3] : nullptr;
+
+    // Fresh resource directory with the folder the plugin keeps its ini file in
+    namespace fs = std::filesystem;
+    std::error_code error;
+    fs::path resource = fs::temp_directory_path(error) / ("kksim-" + std::to_string(std::random_device()()));
+    fs::create_directories(resource / "UserPlugins" / "ReaKontrolConfig", error);
+    MockHost::get().resourcePath = resource.string();
+
+    std::ostringstream out;
+    bool ran = runScript(script, out);
+    std::remove(configFilePath(resource.string()).c_str());
+    fs::remove_all(resource, error);
+    if (!ran) {
+        return 2;
+    }
+    std::cout << out.str();
+
+    if (golden) {
+        std::ifstream expectedFile(golden);
+        std::stringstream expected;
+        expected << expectedFile.rdbuf();
+        if (!expectedFile || expected.str() != out.str()) {
+            std::cerr << "kksim: output differs from " << golden << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,1049 @@
+#include "MockHost.h"
+#include "TimerWheel.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+
+extern "C" REAPER_PLUGIN_DLL_EXPORT int REAPER_PLUGIN_ENTRYPOINT(REAPER_PLUGIN_HINSTANCE hInstance, reaper_plugin_info_t* rec);
+
+namespace {
+    typedef bool (*HookCommandFunc)(int command, int flag);
+    HookCommandFunc hookCommand = nullptr;
+
+    MockHost& host() {
+        return MockHost::get();
+    }
+
+    MockProject& proj() {
+        return MockHost::get().project();
+    }
+
+    // Like REAPER: notifies every registered surface except the one causing the change
+    template <typename Notify>
+    void notifySurfaces(IReaperControlSurface* ignoresurf, Notify notify) {
+        for (IReaperControlSurface* csurf : host().surfaces()) {
+            if (csurf != ignoresurf) notify(csurf);
+        }
+    }
+
+    MockTrack* asTrack(MediaTrack* tr) {
+        return host().hasTrack(tr) ? reinterpret_cast<MockTrack*>(tr) : nullptr;
+    }
+
+    bool anySolo() {
+        for (size_t i = 1; i < proj().tracks.size(); ++i) {
+            if (proj().tracks[i].solo) return true;
+        }
+        return false;
+    }
+
+    // ---- MIDI devices ----
+
+    int fake_GetNumMIDIInputs() { return host().deviceCount(); }
+    int fake_GetNumMIDIOutputs() { return host().deviceCount(); }
+
+    bool fake_GetMIDIInputName(int dev, char* nameout, int nameout_sz) {
+        return host().deviceListed(dev, true, nameout, nameout_sz);
+    }
+
+    bool fake_GetMIDIOutputName(int dev, char* nameout, int nameout_sz) {
+        return host().deviceListed(dev, false, nameout, nameout_sz);
+    }
+
+    midi_Input* fake_CreateMIDIInput(int dev) {
+        char name[128];
+        if (dev != host().deviceCount() - 1 || !host().deviceListed(dev, true, name, sizeof(name))) return nullptr;
+        return new MockMidiInput(host().wire());
+    }
+
+    midi_Output* fake_CreateMIDIOutput(int dev, bool streamMode, int* msoffset100) {
+        char name[128];
+        if (dev != host().deviceCount() - 1 || !host().deviceListed(dev, false, name, sizeof(name))) return nullptr;
+        return new MockMidiOutput(host().wire());
+    }
+
+    // ---- Tracks ----
+
+    int fake_GetNumTracks() { return static_cast<int>(proj().tracks.size()) - 1; }
+    int fake_CSurf_NumTracks(bool mcpView) { return fake_GetNumTracks(); }
+    MediaTrack* fake_CSurf_TrackFromID(int idx, bool mcpView) { return host().trackPtr(idx); }
+    int fake_CSurf_TrackToID(MediaTrack* track, bool mcpView) { return host().trackId(track); }
+    MediaTrack* fake_GetLastTouchedTrack() { return nullptr; }
+    void fake_CSurf_OnTrackSelection(MediaTrack* trackid) {}
+    MediaTrack* fake_SetMixerScroll(MediaTrack* leftmosttrack) { return leftmosttrack; }
+
+    void* fake_GetSetMediaTrackInfo(MediaTrack* tr, const char* parmname, void* setNewValue) {
+        MockTrack* t = asTrack(tr);
+        if (!t || !parmname) return nullptr;
+        if (!strcmp(parmname, "P_NAME")) {
+            if (setNewValue) t->name = static_cast<const char*>(setNewValue);
+            return const_cast<char*>(t->name.c_str());
+        }
+        if (!strcmp(parmname, "I_SELECTED")) {
+            if (setNewValue && t->selected != *static_cast<int*>(setNewValue)) {
+                t->selected = *static_cast<int*>(setNewValue);
+                host().markSelectionDirty();
+            }
+            return &t->selected;
+        }
+        if (!strcmp(parmname, "I_AUTOMODE")) {
+            if (setNewValue) {
+                t->autoMode = *static_cast<int*>(setNewValue);
+                host().markSelectionDirty(); // REAPER reports automation mode changes through SetSurfaceSelected
+            }
+            return &t->autoMode;
+        }
+        if (!strcmp(parmname, "I_SOLO")) {
+            if (setNewValue) t->solo = *static_cast<int*>(setNewValue);
+            return &t->solo;
+        }
+        if (!strcmp(parmname, "I_RECARM")) {
+            if (setNewValue) t->recArm = *static_cast<int*>(setNewValue);
+            return &t->recArm;
+        }
+        if (!strcmp(parmname, "B_MUTE")) {
+            if (setNewValue) t->mute = *static_cast<bool*>(setNewValue);
+            return &t->mute;
+        }
+        if (!strcmp(parmname, "D_VOL")) {
+            if (setNewValue) t->volume = *static_cast<double*>(setNewValue);
+            return &t->volume;
+        }
+        if (!strcmp(parmname, "D_PAN")) {
+            if (setNewValue) t->pan = *static_cast<double*>(setNewValue);
+            return &t->pan;
+        }
+        return nullptr;
+    }
+
+    bool fake_GetSetMediaTrackInfo_String(MediaTrack* tr, const char* parmname, char* stringNeedBig, bool setNewValue) {
+        MockTrack* t = asTrack(tr);
+        if (!t || !parmname || !stringNeedBig || strcmp(parmname, "P_NAME")) return false;
+        if (setNewValue) {
+            t->name = stringNeedBig;
+        }
+        else {
+            strcpy(stringNeedBig, t->name.c_str());
+        }
+        return true;
+    }
+
+    GUID* fake_GetTrackGUID(MediaTrack* tr) {
+        static GUID none = {};
+        MockTrack* t = asTrack(tr);
+        return t ? &t->guid : &none;
+    }
+
+    double fake_GetMediaTrackInfo_Value(MediaTrack* tr, const char* parmname) {
+        MockTrack* t = asTrack(tr);
+        if (!t || !parmname) return 0.0;
+        if (!strcmp(parmname, "I_SELECTED")) return t->selected;
+        if (!strcmp(parmname, "I_AUTOMODE")) return t->autoMode;
+        if (!strcmp(parmname, "I_SOLO")) return t->solo;
+        if (!strcmp(parmname, "I_RECARM")) return t->recArm;
+        if (!strcmp(parmname, "B_MUTE")) return t->mute ? 1.0 : 0.0;
+        if (!strcmp(parmname, "D_VOL")) return t->volume;
+        if (!strcmp(parmname, "D_PAN")) return t->pan;
+        if (!strcmp(parmname, "B_SHOWINMIXER")) return t->showInMixer ? 1.0 : 0.0;
+        if (!strcmp(parmname, "I_FOLDERDEPTH")) return t->folderDepth;
+        if (!strcmp(parmname, "I_FOLDERCOMPACT")) return t->folderCompact;
+        return 0.0;
+    }
+
+    double fake_Track_GetPeakInfo(MediaTrack* track, int channel) {
+        MockTrack* t = asTrack(track);
+        return (t && channel >= 0 && channel < 2) ? t->peak[channel] : 0.0;
+    }
+
+    bool fake_GetTrackStateChunk(MediaTrack* track, char* strNeedBig, int strNeedBig_sz, bool isundoOptional) { return false; }
+    int fake_CountTrackMediaItems(MediaTrack* track) {
+        MockTrack* t = asTrack(track);
+        return t ? static_cast<int>(t->items.size()) : 0;
+    }
+    int fake_GetTrackNumMediaItems(MediaTrack* tr) { return fake_CountTrackMediaItems(tr); }
+
+    MediaItem* fake_GetTrackMediaItem(MediaTrack* tr, int itemidx) {
+        MockTrack* t = asTrack(tr);
+        if (!t || itemidx < 0 || itemidx >= static_cast<int>(t->items.size())) return nullptr;
+        return reinterpret_cast<MediaItem*>(&t->items[itemidx]);
+    }
+
+    double fake_GetMediaItemInfo_Value(MediaItem* item, const char* parmname) {
+        const MockItem* i = reinterpret_cast<const MockItem*>(item);
+        if (!i || !parmname) return 0.0;
+        if (!strcmp(parmname, "D_POSITION")) return i->position;
+        if (!strcmp(parmname, "D_LENGTH")) return i->length;
+        return 0.0;
+    }
+
+    // A take is the item itself, items without a take name have none
+    MediaItem_Take* fake_GetActiveTake(MediaItem* item) {
+        const MockItem* i = reinterpret_cast<const MockItem*>(item);
+        return (i && !i->takeName.empty()) ? reinterpret_cast<MediaItem_Take*>(item) : nullptr;
+    }
+
+    const char* fake_GetTakeName(MediaItem_Take* take) {
+        return take ? reinterpret_cast<const MockItem*>(take)->takeName.c_str() : nullptr;
+    }
+
+    int fake_GetProjectStateChangeCount(ReaProject* p) { return proj().stateChangeCount; }
+
+    void fake_format_timestr_pos(double tpos, char* buf, int buf_sz, int modeoverride) {
+        if (buf && buf_sz > 0) snprintf(buf, buf_sz, "%.3f", tpos);
+    }
+
+    // ---- Surface feedback ----
+
+    double fake_CSurf_OnVolumeChange(MediaTrack* trackid, double volume, bool relative) {
+        MockTrack* t = asTrack(trackid);
+        if (!t) return 0.0;
+        if (relative) {
+            double db = (t->volume > 0.0 ? 20.0 * log10(t->volume) : -150.0) + volume;
+            t->volume = pow(10.0, db / 20.0);
+        }
+        else {
+            t->volume = volume;
+        }
+        if (t->volume > 3.981071705534972) t->volume = 3.981071705534972; // +12dB
+        return t->volume;
+    }
+
+    double fake_CSurf_OnPanChange(MediaTrack* trackid, double pan, bool relative) {
+        MockTrack* t = asTrack(trackid);
+        if (!t) return 0.0;
+        t->pan = relative ? t->pan + pan : pan;
+        if (t->pan < -1.0) t->pan = -1.0;
+        if (t->pan > 1.0) t->pan = 1.0;
+        return t->pan;
+    }
+
+    bool fake_CSurf_OnMuteChange(MediaTrack* trackid, int mute) {
+        MockTrack* t = asTrack(trackid);
+        if (!t) return false;
+        t->mute = (mute < 0) ? !t->mute : (mute != 0);
+        notifySurfaces(nullptr, [&](IReaperControlSurface* csurf) { csurf->SetSurfaceMute(trackid, t->mute); });
+        return t->mute;
+    }
+
+    bool fake_CSurf_OnSoloChange(MediaTrack* trackid, int solo) {
+        MockTrack* t = asTrack(trackid);
+        if (!t) return false;
+        t->solo = (solo < 0) ? (t->solo ? 0 : 1) : solo;
+        notifySurfaces(nullptr, [&](IReaperControlSurface* csurf) {
+            csurf->SetSurfaceSolo(trackid, t->solo != 0);
+            csurf->SetSurfaceSolo(host().trackPtr(0), anySolo()); // master reports "any solo"
+        });
+        return t->solo != 0;
+    }
+
+    void fake_CSurf_SetSurfaceVolume(MediaTrack* trackid, double volume, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetSurfaceVolume(trackid, volume); });
+    }
+
+    void fake_CSurf_SetSurfacePan(MediaTrack* trackid, double pan, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetSurfacePan(trackid, pan); });
+    }
+
+    void fake_CSurf_SetSurfaceMute(MediaTrack* trackid, bool mute, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetSurfaceMute(trackid, mute); });
+    }
+
+    void fake_CSurf_SetSurfaceSolo(MediaTrack* trackid, bool solo, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetSurfaceSolo(trackid, solo); });
+    }
+
+    void fake_CSurf_SetSurfaceRecArm(MediaTrack* trackid, bool recarm, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetSurfaceRecArm(trackid, recarm); });
+    }
+
+    void fake_CSurf_SetPlayState(bool play, bool pause, bool rec, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetPlayState(play, pause, rec); });
+    }
+
+    void fake_CSurf_SetRepeatState(bool rep, IReaperControlSurface* ignoresurf) {
+        notifySurfaces(ignoresurf, [&](IReaperControlSurface* csurf) { csurf->SetRepeatState(rep); });
+    }
+
+    void fake_CSurf_SetTrackListChange() {
+        notifySurfaces(nullptr, [&](IReaperControlSurface* csurf) { csurf->SetTrackListChange(); });
+    }
+
+    // ---- Transport ----
+
+    void fake_CSurf_OnPlay() { host().setPlayState(true, false, (proj().playState & 4) != 0); }
+    void fake_CSurf_OnStop() { host().setPlayState(false, false, false); }
+    void fake_CSurf_OnRecord() { host().setPlayState(true, false, !(proj().playState & 4)); }
+    void fake_CSurf_GoStart() { proj().cursor = 0.0; }
+    void fake_CSurf_ScrubAmt(double amt) { proj().cursor += amt; }
+    int fake_GetPlayState() { return proj().playState; }
+    bool fake_AnyTrackSolo(ReaProject* proj) { return anySolo(); }
+
+    int fake_GetSetRepeat(int val) {
+        if (val >= 0) {
+            proj().repeat = (val == 2) ? !proj().repeat : (val != 0);
+            fake_CSurf_SetRepeatState(proj().repeat != 0, nullptr);
+        }
+        return proj().repeat;
+    }
+
+    int fake_GetGlobalAutomationOverride() { return proj().globalAutoOverride; }
+    void fake_SetGlobalAutomationOverride(int mode) { proj().globalAutoOverride = mode; host().markSelectionDirty(); }
+
+    double fake_GetCursorPosition() { return proj().cursor; }
+    void fake_SetEditCurPos(double time, bool moveview, bool seekplay) { proj().cursor = time; }
+    double fake_GetPlayPosition() { return proj().cursor; }
+
+    int fake_CountProjectMarkers(ReaProject* p, int* num_markersOut, int* num_regionsOut) {
+        int regions = 0;
+        for (const MockMarker& marker : proj().markers) {
+            if (marker.isRegion) ++regions;
+        }
+        int total = static_cast<int>(proj().markers.size());
+        if (num_markersOut) *num_markersOut = total - regions;
+        if (num_regionsOut) *num_regionsOut = regions;
+        return total;
+    }
+
+    int fake_EnumProjectMarkers3(ReaProject* p, int idx, bool* isrgnOut, double* posOut, double* rgnendOut,
+                                 const char** nameOut, int* markrgnindexnumberOut, int* colorOut) {
+        if (idx < 0 || idx >= static_cast<int>(proj().markers.size())) return 0;
+        const MockMarker& marker = proj().markers[idx];
+        if (isrgnOut) *isrgnOut = marker.isRegion;
+        if (posOut) *posOut = marker.position;
+        if (rgnendOut) *rgnendOut = marker.regionEnd;
+        if (nameOut) *nameOut = marker.name.c_str();
+        if (markrgnindexnumberOut) *markrgnindexnumberOut = marker.number;
+        if (colorOut) *colorOut = 0;
+        return idx + 1;
+    }
+
+    void fake_TimeMap_GetTimeSigAtTime(ReaProject* p, double time, int* timesig_numOut, int* timesig_denomOut, double* tempoOut) {
+        if (timesig_numOut) *timesig_numOut = 4;
+        if (timesig_denomOut) *timesig_denomOut = 4;
+        if (tempoOut) *tempoOut = proj().tempo;
+    }
+
+    void fake_GetSet_LoopTimeRange(bool isSet, bool isLoop, double* startOut, double* endOut, bool allowautoseek) {
+        if (!startOut || !endOut) return;
+        if (isSet) {
+            proj().loopStart = *startOut;
+            proj().loopEnd = *endOut;
+        }
+        else {
+            *startOut = proj().loopStart;
+            *endOut = proj().loopEnd;
+        }
+    }
+
+    // ---- Actions ----
+
+    double previousMarkerOrStart(double time) {
+        double found = 0.0;
+        for (const MockMarker& m : proj().markers) {
+            if (m.position < time) found = m.position;
+        }
+        return found;
+    }
+
+    double nextMarkerOrEnd(double time) {
+        // Project end: the last marker, region end or item end
+        double end = 0.0;
+        for (const MockMarker& m : proj().markers) {
+            if (m.position > time) return m.position;
+            end = std::max(end, m.isRegion ? m.regionEnd : m.position);
+        }
+        for (const MockTrack& t : proj().tracks) {
+            for (const MockItem& item : t.items) end = std::max(end, item.position + item.length);
+        }
+        return std::max(end, time);
+    }
+
+    void fake_Main_OnCommand(int command, int flag) {
+        host().commandLog.push_back(command);
+        if (hookCommand && hookCommand(command, flag)) return;
+        switch (command) {
+        case 40364: // Options: Toggle metronome
+            proj().metronome ^= 1;
+            break;
+        case 41745: // Enable metronome
+            proj().metronome |= 1;
+            break;
+        case 41746: // Disable metronome
+            proj().metronome &= ~1;
+            break;
+        case 1068: // Toggle repeat
+            fake_GetSetRepeat(2);
+            return;
+        case 40172: // Markers: Go to previous marker/project start
+            proj().cursor = previousMarkerOrStart(proj().cursor);
+            return;
+        case 40173: // Markers: Go to next marker/project end
+            proj().cursor = nextMarkerOrEnd(proj().cursor);
+            return;
+        default:
+            return;
+        }
+        notifySurfaces(nullptr, [&](IReaperControlSurface* csurf) {
+            csurf->Extended(CSURF_EXT_SETMETRONOME, (void*)(intptr_t)(proj().metronome & 1), nullptr, nullptr);
+        });
+    }
+
+    int fake_GetToggleCommandState(int command_id) {
+        switch (command_id) {
+        case 40364: // Options: Toggle metronome
+            return proj().metronome & 1;
+        case 1068: // Toggle repeat
+            return fake_GetSetRepeat(-1);
+        default:
+            return -1; // not a toggle action
+        }
+    }
+
+    int fake_NamedCommandLookup(const char* command_name) {
+        if (!command_name || !*command_name) return 0;
+        if (command_name[0] != '_') return atoi(command_name);
+        return 0; // no extensions (SWS etc.) in the mock host
+    }
+
+    // ---- Config ----
+
+    const int METRONOME_OFFSET = 1;
+
+    void* fake_get_config_var(const char* name, int* szOut) { return nullptr; }
+
+    int fake_projectconfig_var_getoffs(const char* name, int* szOut) {
+        if (name && !strcmp(name, "projmetroen")) {
+            if (szOut) *szOut = sizeof(int);
+            return METRONOME_OFFSET;
+        }
+        return 0;
+    }
+
+    void* fake_projectconfig_var_addr(ReaProject* p, int idx) {
+        return (idx == METRONOME_OFFSET) ? &proj().metronome : nullptr;
+    }
+
+    ReaProject* fake_EnumProjects(int idx, char* projfnOutOptional, int projfnOutOptional_sz) {
+        if (projfnOutOptional && projfnOutOptional_sz > 0) projfnOutOptional[0] = '\0';
+        return (idx <= 0) ? reinterpret_cast<ReaProject*>(&proj()) : nullptr;
+    }
+
+    // ---- UI / misc ----
+
+    void fake_ShowConsoleMsg(const char* msg) {
+        if (!msg) return;
+        host().console += msg;
+        if (host().echoConsole) fputs(msg, stdout);
+    }
+
+    int fake_ShowMessageBox(const char* msg, const char* title, int type) {
+        host().messageBoxes.push_back(msg ? msg : "");
+        return host().messageBoxAnswer;
+    }
+
+    void fake_Help_Set(const char* helpstring, bool is_temporary_help) {}
+    const char* fake_GetResourcePath() { return host().resourcePath.c_str(); }
+
+    bool fake_file_exists(const char* path) {
+        FILE* f = path ? fopen(path, "rb") : nullptr;
+        if (!f) return false;
+        fclose(f);
+        return true;
+    }
+
+    char* fake_GetSetObjectState2(void* obj, const char* str, bool isundo) { return nullptr; }
+    void fake_FreeHeapPtr(void* ptr) { free(ptr); }
+
+    void fake_mkvolstr(char* strNeed64, double vol) {
+        if (vol < 0.0000000298023223876953125) {
+            snprintf(strNeed64, 64, "-inf");
+        }
+        else {
+            snprintf(strNeed64, 64, "%+.2fdB", 20.0 * log10(vol));
+        }
+    }
+
+    void fake_mkpanstr(char* strNeed64, double pan) {
+        int percent = static_cast<int>(fabs(pan) * 100.0 + 0.5);
+        if (percent == 0) {
+            snprintf(strNeed64, 64, "center");
+        }
+        else {
+            snprintf(strNeed64, 64, "%d%%%c", percent, pan < 0.0 ? 'L' : 'R');
+        }
+    }
+
+    // ---- FX ----
+
+    MockFx* asFx(MediaTrack* track, int fx) {
+        MockTrack* t = asTrack(track);
+        if (!t || fx < 0 || fx >= static_cast<int>(t->fx.size())) return nullptr;
+        return &t->fx[fx];
+    }
+
+    int fake_TrackFX_GetCount(MediaTrack* track) {
+        MockTrack* t = asTrack(track);
+        return t ? static_cast<int>(t->fx.size()) : 0;
+    }
+
+    bool fake_TrackFX_GetFXName(MediaTrack* track, int fx, char* bufOut, int bufOut_sz) {
+        MockFx* f = asFx(track, fx);
+        if (!f) return false;
+        snprintf(bufOut, bufOut_sz, "%s", f->name.c_str());
+        return true;
+    }
+
+    GUID* fake_TrackFX_GetFXGUID(MediaTrack* track, int fx) {
+        MockFx* f = asFx(track, fx);
+        return f ? &f->guid : nullptr;
+    }
+
+    int fake_TrackFX_GetNumParams(MediaTrack* track, int fx) {
+        MockFx* f = asFx(track, fx);
+        return f ? static_cast<int>(f->params.size()) : 0;
+    }
+
+    bool fake_TrackFX_GetParamName(MediaTrack* track, int fx, int param, char* bufOut, int bufOut_sz) {
+        MockFx* f = asFx(track, fx);
+        if (!f || param < 0 || param >= static_cast<int>(f->params.size())) return false;
+        snprintf(bufOut, bufOut_sz, "Param %d", param + 1);
+        return true;
+    }
+
+    double fake_TrackFX_GetParam(MediaTrack* track, int fx, int param, double* minvalOut, double* maxvalOut) {
+        MockFx* f = asFx(track, fx);
+        if (minvalOut) *minvalOut = 0.0;
+        if (maxvalOut) *maxvalOut = 1.0;
+        if (!f || param < 0 || param >= static_cast<int>(f->params.size())) return 0.0;
+        return f->params[param];
+    }
+
+    double fake_TrackFX_GetParamNormalized(MediaTrack* track, int fx, int param) {
+        return fake_TrackFX_GetParam(track, fx, param, nullptr, nullptr);
+    }
+
+    bool fake_TrackFX_SetParamNormalized(MediaTrack* track, int fx, int param, double value) {
+        MockFx* f = asFx(track, fx);
+        if (!f || param < 0 || param >= static_cast<int>(f->params.size())) return false;
+        f->params[param] = value;
+        return true;
+    }
+
+    bool fake_TrackFX_GetFormattedParamValue(MediaTrack* track, int fx, int param, char* bufOut, int bufOut_sz) {
+        MockFx* f = asFx(track, fx);
+        if (!f || param < 0 || param >= static_cast<int>(f->params.size())) return false;
+        snprintf(bufOut, bufOut_sz, "%.1f %%", f->params[param] * 100.0);
+        return true;
+    }
+
+    bool fake_TrackFX_GetParameterStepSizes(MediaTrack* track, int fx, int param, double* stepOut, double* smallstepOut,
+        double* largestepOut, bool* istoggleOut) {
+        MockFx* f = asFx(track, fx);
+        if (!f || param < 0 || param >= static_cast<int>(f->params.size())) return false;
+        if (param % 10 == 9) {
+            *stepOut = *smallstepOut = *largestepOut = 1.0;
+            *istoggleOut = true;
+            return true;
+        }
+        if (param % 10 == 4) {
+            *stepOut = *smallstepOut = *largestepOut = 1.0 / 3.0;
+            *istoggleOut = false;
+            return true;
+        }
+        return false; // continuous
+    }
+
+    bool fake_TrackFX_GetNamedConfigParm(MediaTrack* track, int fx, const char* parmname, char* bufOutNeedBig, int bufOutNeedBig_sz) { return false; }
+    bool fake_TrackFX_SetNamedConfigParm(MediaTrack* track, int fx, const char* parmname, const char* value) { return false; }
+    void fake_TrackFX_SetOffline(MediaTrack* track, int fx, bool offline) {}
+    bool fake_TrackFX_GetOpen(MediaTrack* track, int fx) { return false; }
+    void fake_TrackFX_Show(MediaTrack* track, int index, int showFlag) {}
+    bool fake_TrackFX_GetPreset(MediaTrack* track, int fx, char* presetnameOut, int presetnameOut_sz) { return false; }
+
+    // ---- Sends / receives ----
+
+    // Send index of category 0 of tr or, for category -1, the index-th send to tr in track order
+    MockSend* asRoute(MediaTrack* tr, int category, int index, int* otherId = nullptr) {
+        int id = host().trackId(tr);
+        if (id < 0 || index < 0) return nullptr;
+        if (category == 0) {
+            MockTrack& t = proj().tracks[id];
+            if (index >= static_cast<int>(t.sends.size())) return nullptr;
+            if (otherId) *otherId = t.sends[index].dest;
+            return &t.sends[index];
+        }
+        if (category != -1) return nullptr;
+        for (size_t src = 0; src < proj().tracks.size(); ++src) {
+            for (MockSend& send : proj().tracks[src].sends) {
+                if (send.dest == id && index-- == 0) {
+                    if (otherId) *otherId = static_cast<int>(src);
+                    return &send;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    int fake_GetTrackNumSends(MediaTrack* tr, int category) {
+        int count = 0;
+        while (asRoute(tr, category, count)) ++count;
+        return count;
+    }
+
+    void* fake_GetSetTrackSendInfo(MediaTrack* tr, int category, int sendidx, const char* parmname, void* setNewValue) {
+        int otherId = 0;
+        MockSend* send = asRoute(tr, category, sendidx, &otherId);
+        if (!send || !parmname) return nullptr;
+        if (!strcmp(parmname, "P_DESTTRACK")) return (category == 0) ? host().trackPtr(otherId) : tr;
+        if (!strcmp(parmname, "P_SRCTRACK")) return (category == 0) ? tr : host().trackPtr(otherId);
+        if (!strcmp(parmname, "D_VOL")) {
+            if (setNewValue) send->volume = *static_cast<double*>(setNewValue);
+            return &send->volume;
+        }
+        if (!strcmp(parmname, "D_PAN")) {
+            if (setNewValue) send->pan = *static_cast<double*>(setNewValue);
+            return &send->pan;
+        }
+        if (!strcmp(parmname, "B_MUTE")) {
+            if (setNewValue) send->mute = *static_cast<bool*>(setNewValue);
+            return &send->mute;
+        }
+        return nullptr;
+    }
+
+    double routeVolumeChange(MockSend* send, double volume, bool relative) {
+        if (!send) return 0.0;
+        if (relative) {
+            double db = (send->volume > 0.0 ? 20.0 * log10(send->volume) : -150.0) + volume;
+            send->volume = pow(10.0, db / 20.0);
+        }
+        else {
+            send->volume = volume;
+        }
+        if (send->volume > 3.981071705534972) send->volume = 3.981071705534972; // +12dB
+        return send->volume;
+    }
+
+    double routePanChange(MockSend* send, double pan, bool relative) {
+        if (!send) return 0.0;
+        send->pan = std::max(-1.0, std::min(relative ? send->pan + pan : pan, 1.0));
+        return send->pan;
+    }
+
+    double fake_CSurf_OnSendVolumeChange(MediaTrack* trackid, int send_index, double volume, bool relative) {
+        return routeVolumeChange(asRoute(trackid, 0, send_index), volume, relative);
+    }
+
+    double fake_CSurf_OnSendPanChange(MediaTrack* trackid, int send_index, double pan, bool relative) {
+        return routePanChange(asRoute(trackid, 0, send_index), pan, relative);
+    }
+
+    double fake_CSurf_OnRecvVolumeChange(MediaTrack* trackid, int recv_index, double volume, bool relative) {
+        return routeVolumeChange(asRoute(trackid, -1, recv_index), volume, relative);
+    }
+
+    double fake_CSurf_OnRecvPanChange(MediaTrack* trackid, int recv_index, double pan, bool relative) {
+        return routePanChange(asRoute(trackid, -1, recv_index), pan, relative);
+    }
+
+    // ---- Plugin registration ----
+
+    int registerTrampoline(const char* name, void* infostruct) {
+        return host().registerItem(name, infostruct);
+    }
+
+    void* getFuncTrampoline(const char* name) {
+        return host().getFunc(name);
+    }
+
+    struct FuncEntry {
+        const char* name;
+        void* func;
+    };
+
+#define MOCK_FUNC(name) { #name, (void*)&fake_##name }
+
+    const FuncEntry funcTable[] = {
+        MOCK_FUNC(GetNumMIDIInputs),
+        MOCK_FUNC(GetMIDIInputName),
+        MOCK_FUNC(GetNumMIDIOutputs),
+        MOCK_FUNC(GetMIDIOutputName),
+        MOCK_FUNC(CreateMIDIInput),
+        MOCK_FUNC(CreateMIDIOutput),
+        MOCK_FUNC(GetNumTracks),
+        MOCK_FUNC(CSurf_NumTracks),
+        MOCK_FUNC(CSurf_TrackToID),
+        MOCK_FUNC(CSurf_TrackFromID),
+        MOCK_FUNC(CSurf_OnTrackSelection),
+        MOCK_FUNC(GetLastTouchedTrack),
+        MOCK_FUNC(CSurf_OnPlay),
+        MOCK_FUNC(ShowConsoleMsg),
+        MOCK_FUNC(TrackFX_GetCount),
+        MOCK_FUNC(TrackFX_GetFXName),
+        MOCK_FUNC(TrackFX_GetParamName),
+        MOCK_FUNC(TrackFX_GetFXGUID),
+        MOCK_FUNC(TrackFX_GetNumParams),
+        MOCK_FUNC(TrackFX_GetParam),
+        MOCK_FUNC(TrackFX_GetParamNormalized),
+        MOCK_FUNC(TrackFX_SetParamNormalized),
+        MOCK_FUNC(TrackFX_GetFormattedParamValue),
+        MOCK_FUNC(TrackFX_GetParameterStepSizes),
+        MOCK_FUNC(GetTrackNumSends),
+        MOCK_FUNC(GetSetTrackSendInfo),
+        MOCK_FUNC(CSurf_OnSendVolumeChange),
+        MOCK_FUNC(CSurf_OnSendPanChange),
+        MOCK_FUNC(CSurf_OnRecvVolumeChange),
+        MOCK_FUNC(CSurf_OnRecvPanChange),
+        MOCK_FUNC(CSurf_GoStart),
+        MOCK_FUNC(CSurf_OnStop),
+        MOCK_FUNC(CSurf_OnRecord),
+        MOCK_FUNC(Main_OnCommand),
+        MOCK_FUNC(CSurf_ScrubAmt),
+        MOCK_FUNC(GetSetMediaTrackInfo),
+        MOCK_FUNC(GetTrackGUID),
+        MOCK_FUNC(CSurf_SetTrackListChange),
+        MOCK_FUNC(CSurf_SetSurfaceVolume),
+        MOCK_FUNC(CSurf_SetSurfacePan),
+        MOCK_FUNC(CSurf_SetPlayState),
+        MOCK_FUNC(CSurf_SetRepeatState),
+        MOCK_FUNC(CSurf_SetSurfaceMute),
+        MOCK_FUNC(CSurf_SetSurfaceSolo),
+        MOCK_FUNC(CSurf_SetSurfaceRecArm),
+        MOCK_FUNC(CSurf_OnVolumeChange),
+        MOCK_FUNC(CSurf_OnPanChange),
+        MOCK_FUNC(CSurf_OnMuteChange),
+        MOCK_FUNC(CSurf_OnSoloChange),
+        MOCK_FUNC(GetPlayState),
+        MOCK_FUNC(AnyTrackSolo),
+        MOCK_FUNC(GetSetRepeat),
+        MOCK_FUNC(GetGlobalAutomationOverride),
+        MOCK_FUNC(SetGlobalAutomationOverride),
+        MOCK_FUNC(Track_GetPeakInfo),
+        MOCK_FUNC(mkvolstr),
+        MOCK_FUNC(mkpanstr),
+        MOCK_FUNC(get_config_var),
+        MOCK_FUNC(projectconfig_var_getoffs),
+        MOCK_FUNC(projectconfig_var_addr),
+        MOCK_FUNC(EnumProjects),
+        MOCK_FUNC(SetMixerScroll),
+        MOCK_FUNC(GetTrackStateChunk),
+        MOCK_FUNC(GetCursorPosition),
+        MOCK_FUNC(GetPlayPosition),
+        MOCK_FUNC(CountProjectMarkers),
+        MOCK_FUNC(EnumProjectMarkers3),
+        MOCK_FUNC(SetEditCurPos),
+        MOCK_FUNC(TimeMap_GetTimeSigAtTime),
+        MOCK_FUNC(GetSet_LoopTimeRange),
+        MOCK_FUNC(Help_Set),
+        MOCK_FUNC(ShowMessageBox),
+        MOCK_FUNC(GetResourcePath),
+        MOCK_FUNC(file_exists),
+        MOCK_FUNC(NamedCommandLookup),
+        MOCK_FUNC(GetToggleCommandState),
+        MOCK_FUNC(GetSetObjectState2),
+        MOCK_FUNC(FreeHeapPtr),
+        MOCK_FUNC(TrackFX_GetNamedConfigParm),
+        MOCK_FUNC(TrackFX_SetNamedConfigParm),
+        MOCK_FUNC(TrackFX_SetOffline),
+        MOCK_FUNC(TrackFX_GetOpen),
+        MOCK_FUNC(TrackFX_Show),
+        MOCK_FUNC(TrackFX_GetPreset),
+        MOCK_FUNC(GetSetMediaTrackInfo_String),
+        MOCK_FUNC(CountTrackMediaItems),
+        MOCK_FUNC(GetMediaTrackInfo_Value),
+        MOCK_FUNC(GetTrackNumMediaItems),
+        MOCK_FUNC(GetTrackMediaItem),
+        MOCK_FUNC(GetMediaItemInfo_Value),
+        MOCK_FUNC(GetActiveTake),
+        MOCK_FUNC(GetTakeName),
+        MOCK_FUNC(GetProjectStateChangeCount),
+        MOCK_FUNC(format_timestr_pos),
+    };
+
+#undef MOCK_FUNC
+}
+
+MockHost& MockHost::get() {
+    static MockHost instance;
+    return instance;
+}
+
+MockHost::MockHost() {
+    memset(&rec, 0, sizeof(rec));
+    rec.caller_version = REAPER_PLUGIN_VERSION;
+    rec.Register = registerTrampoline;
+    rec.GetFunc = getFuncTrampoline;
+    setTrackCount(8);
+    // The plugin's timers run on the virtual clock, so sessions don't depend on how fast the host runs them
+    setMonotonicClock([]() { return MockHost::get().now(); });
+}
+
+void MockHost::setTrackCount(int numTracks) {
+    static unsigned long nextGuid = 1;
+    proj.tracks.resize(numTracks + 1);
+    proj.tracks[0].name = "MASTER";
+    for (int id = 0; id <= numTracks; ++id) {
+        if (id > 0 && proj.tracks[id].name.empty()) {
+            proj.tracks[id].name = "Track " + std::to_string(id);
+        }
+        if (proj.tracks[id].guid.Data1 == 0) {
+            proj.tracks[id].guid.Data1 = nextGuid++;
+        }
+    }
+}
+
+void MockHost::addFx(int id, const std::string& name, int numParams) {
+    static unsigned long nextGuid = 1;
+    MockTrack* t = track(id);
+    if (!t) return;
+    MockFx fx;
+    fx.name = name;
+    fx.guid.Data1 = nextGuid++;
+    fx.guid.Data2 = 0xF0; // apart from the track GUIDs
+    fx.params.assign(numParams > 0 ? numParams : 0, 0.5);
+    t->fx.push_back(fx);
+}
+
+void MockHost::addSend(int id, int destId) {
+    MockTrack* t = track(id);
+    if (!t || !track(destId) || destId == id) return;
+    MockSend send;
+    send.dest = destId;
+    t->sends.push_back(send);
+}
+
+void MockHost::addMarker(double position, double regionEnd, const std::string& name) {
+    MockMarker marker;
+    marker.position = position;
+    marker.isRegion = regionEnd >= 0.0;
+    marker.regionEnd = marker.isRegion ? regionEnd : position;
+    marker.name = name;
+    for (const MockMarker& other : proj.markers) {
+        if (other.isRegion == marker.isRegion) marker.number = std::max(marker.number, other.number);
+    }
+    ++marker.number;
+    auto it = std::upper_bound(proj.markers.begin(), proj.markers.end(), marker,
+        [](const MockMarker& a, const MockMarker& b) { return a.position < b.position; });
+    proj.markers.insert(it, marker);
+    notifySurfaces(nullptr, [](IReaperControlSurface* csurf) {
+        csurf->Extended(CSURF_EXT_SETPROJECTMARKERCHANGE, nullptr, nullptr, nullptr);
+    });
+}
+
+void MockHost::addItem(int id, double position, const std::string& takeName) {
+    MockTrack* t = track(id);
+    if (!t) return;
+    MockItem item;
+    item.position = position;
+    item.takeName = takeName;
+    t->items.push_back(item);
+    ++proj.stateChangeCount;
+}
+
+MockTrack* MockHost::track(int id) {
+    return (id >= 0 && id < static_cast<int>(proj.tracks.size())) ? &proj.tracks[id] : nullptr;
+}
+
+bool MockHost::hasTrack(MediaTrack* tr) const {
+    return trackId(tr) >= 0;
+}
+
+int MockHost::trackId(MediaTrack* tr) const {
+    const MockTrack* t = reinterpret_cast<const MockTrack*>(tr);
+    if (proj.tracks.empty() || t < &proj.tracks.front() || t > &proj.tracks.back()) return -1;
+    return static_cast<int>(t - &proj.tracks.front());
+}
+
+MediaTrack* MockHost::trackPtr(int id) {
+    return reinterpret_cast<MediaTrack*>(track(id));
+}
+
+void MockHost::setDevicePresent(bool isPresent) {
+    present = isPresent;
+    kkWire.setPlugged(isPresent);
+}
+
+void MockHost::setDeviceNames(const std::string& in, const std::string& out) {
+    inputName = in;
+    outputName = out;
+}
+
+void MockHost::setOtherMidiPorts(int count) {
+    otherPorts = count;
+}
+
+int MockHost::deviceCount() const {
+    return otherPorts + 1; // REAPER keeps the slot of an unplugged device, GetMIDI*Name() then returns false
+}
+
+bool MockHost::deviceListed(int dev, bool input, char* nameOut, int nameOut_sz) const {
+    if (dev < 0 || dev >= deviceCount() || !nameOut || nameOut_sz <= 0) return false;
+    if (dev < otherPorts) {
+        snprintf(nameOut, nameOut_sz, "%s %d", input ? "Generic MIDI In" : "Generic MIDI Out", dev + 1);
+        return true;
+    }
+    if (!present) return false;
+    snprintf(nameOut, nameOut_sz, "%s", input ? inputName.c_str() : outputName.c_str());
+    return true;
+}
+
+bool MockHost::load() {
+    if (!csurfs.empty()) return true;
+    return REAPER_PLUGIN_ENTRYPOINT(nullptr, &rec) != 0 && !csurfs.empty();
+}
+
+void MockHost::unload() {
+    REAPER_PLUGIN_ENTRYPOINT(nullptr, nullptr);
+    csurfs.clear();
+    hookCommand = nullptr;
+}
+
+void* MockHost::getFunc(const char* name) {
+    for (const FuncEntry& entry : funcTable) {
+        if (!strcmp(entry.name, name)) {
+            return entry.func;
+        }
+    }
+    fprintf(stderr, "MockHost: API function '%s' is not implemented\n", name);
+    return nullptr;
+}
+
+int MockHost::registerItem(const char* name, void* info) {
+    if (!name) return 0;
+    if (!strcmp(name, "csurf_inst")) {
+        csurfs.push_back(static_cast<IReaperControlSurface*>(info));
+        return 1;
+    }
+    if (!strcmp(name, "hookcommand")) {
+        hookCommand = reinterpret_cast<HookCommandFunc>(info);
+        return 1;
+    }
+    if (!strcmp(name, "-hookcommand")) {
+        hookCommand = nullptr;
+        return 1;
+    }
+    if (!strcmp(name, "command_id")) {
+        int id = nextCommandId++;
+        commandIds[id] = info ? static_cast<const char*>(info) : "";
+        return id;
+    }
+    return 1; // gaccel, -gaccel, ...
+}
+
+void MockHost::tick(int count) {
+    for (int i = 0; i < count; ++i) {
+        clockMs += msPerTick;
+        flushSelection();
+        for (IReaperControlSurface* csurf : csurfs) {
+            csurf->Run();
+        }
+    }
+}
+
+void MockHost::tickAt(uint64_t ms) {
+    if (ms > clockMs) {
+        clockMs = ms;
+    }
+    flushSelection();
+    for (IReaperControlSurface* csurf : csurfs) {
+        csurf->Run();
+    }
+}
+
+void MockHost::flushSelection() {
+    if (!selectionDirty || csurfs.empty()) return;
+    selectionDirty = false;
+    // Like REAPER: any selection / arm / automation / name change is reported for every track
+    for (IReaperControlSurface* csurf : csurfs) {
+        for (int id = 0; id < static_cast<int>(proj.tracks.size()); ++id) {
+            csurf->SetSurfaceSelected(trackPtr(id), proj.tracks[id].selected != 0);
+        }
+    }
+}
+
+void MockHost::selectTrack(int id, bool exclusive) {
+    for (int i = 0; i < static_cast<int>(proj.tracks.size()); ++i) {
+        if (i == id) {
+            proj.tracks[i].selected = 1;
+        }
+        else if (exclusive) {
+            proj.tracks[i].selected = 0;
+        }
+    }
+    selectionDirty = true;
+}
+
+void MockHost::setVolume(int id, double volume) {
+    if (MockTrack* t = track(id)) {
+        t->volume = volume;
+        fake_CSurf_SetSurfaceVolume(trackPtr(id), volume, nullptr);
+    }
+}
+
+void MockHost::setPan(int id, double pan) {
+    if (MockTrack* t = track(id)) {
+        t->pan = pan;
+        fake_CSurf_SetSurfacePan(trackPtr(id), pan, nullptr);
+    }
+}
+
+void MockHost::setMute(int id, bool mute) {
+    fake_CSurf_OnMuteChange(trackPtr(id), mute ? 1 : 0);
+}
+
+void MockHost::setSolo(int id, int solo) {
+    fake_CSurf_OnSoloChange(trackPtr(id), solo);
+}
+
+void MockHost::setRecArm(int id, bool armed) {
+    if (MockTrack* t = track(id)) {
+        t->recArm = armed ? 1 : 0;
+        fake_CSurf_SetSurfaceRecArm(trackPtr(id), armed, nullptr);
+        selectionDirty = true;
+    }
+}
+
+void MockHost::setTrackName(int id, const std::string& name) {
+    if (MockTrack* t = track(id)) {
+        t->name = name;
+        selectionDirty = true;
+    }
+}
+
+void MockHost::setPlayState(bool play, bool pause, bool rec) {
+    proj.playState = (play ? 1 : 0) | (pause ? 2 : 0) | (rec ? 4 : 0);
+    fake_CSurf_SetPlayState(play, pause, rec, nullptr);
+}
+
+void MockHost::setShownInMixer(int id, bool shown) {
+    if (MockTrack* t = track(id)) {
+        t->showInMixer = shown;
+        trackListChanged();
+    }
+}
+
+void MockHost::setFolder(int id, int depth, int compact) {
+    if (MockTrack* t = track(id)) {
+        t->folderDepth = depth;
+        t->folderCompact = compact;
+        trackListChanged();
+    }
+}
+
+void MockHost::trackListChanged() {
+    fake_CSurf_SetTrackListChange();
+    selectionDirty = true;
+}
+
+bool MockHost::runAction(const std::string& idstr) {
+    for (const auto& cmd : commandIds) {
+        if (cmd.second == idstr) {
+            fake_Main_OnCommand(cmd.first, 0);
+            return true;
+        }
+    }
+    return false;
+}
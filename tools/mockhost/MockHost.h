@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include "reaKontrol.h"
+#include "MockMidi.h"
+
+// Minimal in-process stand-in for REAPER. It hands the plugin a GetFunc() that resolves every function of the
+// REAPERAPI WANT list to a fake working on MockProject, loads the plugin through its real entry point and drives
+// the registered control surface the way REAPER does (Run() ticks plus the SetSurface* callbacks).
+
+struct MockFx {
+    std::string name;
+    GUID guid = {};
+    std::vector<double> params; // normalized values
+};
+
+struct MockSend {
+    int dest = 0; // track id
+    double volume = 1.0;
+    double pan = 0.0;
+    bool mute = false;
+};
+
+struct MockItem {
+    double position = 0.0;
+    double length = 1.0;
+    std::string takeName; // empty: item without take
+};
+
+struct MockTrack {
+    std::string name;
+    double volume = 1.0;
+    double pan = 0.0;
+    bool mute = false;
+    int solo = 0;
+    int recArm = 0;
+    int selected = 0;
+    int autoMode = 0;
+    bool showInMixer = true;
+    int folderDepth = 0; // I_FOLDERDEPTH: 1 starts a folder, -n closes n levels
+    int folderCompact = 0; // I_FOLDERCOMPACT: 2 = collapsed
+    double peak[2] = { 0.0, 0.0 };
+    std::vector<MockFx> fx;
+    std::vector<MockSend> sends; // receives are the sends of other tracks to this one
+    std::vector<MockItem> items; // in insertion order, REAPER's item order is not relied upon
+    GUID guid = {}; // unique per track, assigned by setTrackCount
+};
+
+struct MockMarker {
+    double position = 0.0;
+    double regionEnd = 0.0;
+    bool isRegion = false;
+    int number = 0;
+    std::string name;
+};
+
+struct MockProject {
+    std::vector<MockTrack> tracks; // tracks[0] is the master track
+    int playState = 0; // &1 = playing, &2 = paused, &4 = recording
+    int repeat = 0;
+    int globalAutoOverride = -1;
+    int metronome = 0; // "projmetroen"
+    int stateChangeCount = 0; // GetProjectStateChangeCount(), counts item edits
+    double cursor = 0.0;
+    double tempo = 120.0;
+    double loopStart = 0.0;
+    double loopEnd = 0.0;
+    std::vector<MockMarker> markers; // in position order like REAPER enumerates them
+};
+
+class MockHost {
+public:
+    static MockHost& get();
+
+    // ---- Project setup ----
+    void setTrackCount(int numTracks); // number of tracks excluding master
+    MockProject& project() { return proj; }
+    MockTrack* track(int id);
+    // Appends an FX with numParams parameters to track id: every 10th parameter is a toggle, every 10th starting with
+    // the 5th has 4 steps, the others are continuous
+    void addFx(int id, const std::string& name, int numParams);
+    void addSend(int id, int destId);
+    // Adds a marker (regionEnd < 0) or region numbered like REAPER does (markers and regions counted separately)
+    // and reports the change to the surfaces
+    void addMarker(double position, double regionEnd, const std::string& name);
+    // Adds an item to track id (an undo point: the project's state change count moves, nothing is reported)
+    void addItem(int id, double position, const std::string& takeName);
+
+    // ---- MIDI devices ----
+    void setDevicePresent(bool present);
+    bool devicePresent() const { return present; }
+    void setDeviceNames(const std::string& inputName, const std::string& outputName);
+    void setOtherMidiPorts(int count); // unrelated ports listed before the keyboard
+    MockMidiWire& wire() { return kkWire; }
+
+    // ---- Plugin lifecycle ----
+    bool load();
+    void unload();
+    IReaperControlSurface* surface() const { return csurfs.empty() ? nullptr : csurfs.front(); }
+    const std::vector<IReaperControlSurface*>& surfaces() const { return csurfs; }
+
+    // ---- Driving the surface ----
+    // Every tick advances the virtual clock behind monotonicMs() by msPerTick (REAPER runs surfaces at about 30 Hz)
+    void tick(int count = 1);
+    void tickAt(uint64_t ms); // single tick at the given virtual time (used to replay captured timing)
+    uint64_t now() const { return clockMs; }
+    int msPerTick = 33;
+    void selectTrack(int id, bool exclusive = true);
+    void setVolume(int id, double volume);
+    void setPan(int id, double pan);
+    void setMute(int id, bool mute);
+    void setSolo(int id, int solo);
+    void setRecArm(int id, bool armed);
+    void setTrackName(int id, const std::string& name); // reported through SetSurfaceSelected like in REAPER
+    void setShownInMixer(int id, bool shown);
+    void setFolder(int id, int depth, int compact);
+    void setPlayState(bool play, bool pause, bool rec);
+    void trackListChanged();
+    bool runAction(const std::string& idstr); // run an action registered by the plugin
+
+    // ---- Observed plugin behaviour ----
+    std::vector<int> commandLog; // Main_OnCommand calls
+    std::vector<std::string> messageBoxes;
+    std::string console;
+    bool echoConsole = false;
+    int messageBoxAnswer = 1;
+    std::string resourcePath = ".";
+
+    // ---- Used by the fake API functions ----
+    void* getFunc(const char* name);
+    int registerItem(const char* name, void* info);
+    void flushSelection();
+    void markSelectionDirty() { selectionDirty = true; }
+    bool hasTrack(MediaTrack* tr) const;
+    int trackId(MediaTrack* tr) const;
+    MediaTrack* trackPtr(int id);
+    bool deviceListed(int dev, bool input, char* nameOut, int nameOut_sz) const;
+    int deviceCount() const;
+
+private:
+    MockHost();
+
+    MockProject proj;
+    MockMidiWire kkWire;
+    bool present = true;
+    bool selectionDirty = false;
+    uint64_t clockMs = 1000;
+    int otherPorts = 0;
+    std::string inputName = "MIDIIN2 (KONTROL S61 MK3)";
+    std::string outputName = "MIDIOUT2 (KONTROL S61 MK3)";
+
+    reaper_plugin_info_t rec;
+    std::vector<IReaperControlSurface*> csurfs; // in registration order
+    int nextCommandId = 50000;
+    std::map<int, std::string> commandIds;
+};
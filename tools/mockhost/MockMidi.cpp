@@ -0,0 +1,140 @@
+#include "MockMidi.h"
+#include <cstring>
+
+// ---- MockMidiEventList ----
+
+void MockMidiEventList::AddItem(MIDI_event_t* evt) {
+    if (!evt || evt->size <= 0) return;
+    addMessage(evt->midi_message, evt->size);
+}
+
+void MockMidiEventList::addMessage(const unsigned char* msg, int size) {
+    // MIDI_event_t always reserves 4 message bytes, longer messages extend past the struct
+    size_t length = sizeof(MIDI_event_t) - 4 + (size > 4 ? size : 4);
+    std::vector<unsigned char> buffer(length, 0);
+    MIDI_event_t* evt = reinterpret_cast<MIDI_event_t*>(buffer.data());
+    evt->frame_offset = 0;
+    evt->size = size;
+    memcpy(evt->midi_message, msg, size);
+    events.push_back(std::move(buffer));
+}
+
+MIDI_event_t* MockMidiEventList::EnumItems(int* bpos) {
+    if (!bpos || *bpos < 0 || *bpos >= static_cast<int>(events.size())) {
+        return nullptr;
+    }
+    return reinterpret_cast<MIDI_event_t*>(events[(*bpos)++].data());
+}
+
+void MockMidiEventList::DeleteItem(int bpos) {
+    if (bpos >= 0 && bpos < static_cast<int>(events.size())) {
+        events.erase(events.begin() + bpos);
+    }
+}
+
+int MockMidiEventList::GetSize() {
+    int size = 0;
+    for (const auto& evt : events) {
+        size += static_cast<int>(evt.size());
+    }
+    return size;
+}
+
+void MockMidiEventList::Empty() {
+    events.clear();
+}
+
+// ---- MockMidiWire ----
+
+void MockMidiWire::inject(const unsigned char* msg, int size) {
+    if (!isPlugged) return;
+    pending.emplace_back(msg, msg + size);
+}
+
+void MockMidiWire::injectCc(unsigned char status, unsigned char d1, unsigned char d2) {
+    const unsigned char msg[3] = { status, d1, d2 };
+    inject(msg, 3);
+}
+
+void MockMidiWire::setOutputListener(OutputListener l) {
+    listener = std::move(l);
+}
+
+void MockMidiWire::setPlugged(bool plugged) {
+    if (plugged == isPlugged) return;
+    isPlugged = plugged;
+    if (!plugged) {
+        pending.clear();
+    }
+    if (plugListener) {
+        plugListener(plugged);
+    }
+}
+
+void MockMidiWire::setPlugListener(PlugListener l) {
+    plugListener = std::move(l);
+}
+
+void MockMidiWire::deliver(const unsigned char* msg, int size) {
+    if (isPlugged && listener) {
+        listener(msg, size);
+    }
+}
+
+void MockMidiWire::swapInto(MockMidiEventList& list) {
+    list.Empty();
+    if (!inputRunning) {
+        pending.clear(); // a stopped input drops everything, like the real driver
+        return;
+    }
+    while (!pending.empty()) {
+        const std::vector<unsigned char>& msg = pending.front();
+        list.addMessage(msg.data(), static_cast<int>(msg.size()));
+        pending.pop_front();
+    }
+}
+
+// ---- MockMidiInput / MockMidiOutput ----
+
+MockMidiInput::MockMidiInput(MockMidiWire& wire) : wire(wire) {
+    wire.openInputs++;
+}
+
+MockMidiInput::~MockMidiInput() {
+    wire.inputRunning = false;
+    wire.openInputs--;
+}
+
+void MockMidiInput::start() {
+    wire.inputRunning = true;
+}
+
+void MockMidiInput::stop() {
+    wire.inputRunning = false;
+}
+
+void MockMidiInput::SwapBufs(unsigned int timestamp) {
+    wire.swapInto(readBuf);
+}
+
+MIDI_eventlist* MockMidiInput::GetReadBuf() {
+    return &readBuf;
+}
+
+MockMidiOutput::MockMidiOutput(MockMidiWire& wire) : wire(wire) {
+    wire.openOutputs++;
+}
+
+MockMidiOutput::~MockMidiOutput() {
+    wire.openOutputs--;
+}
+
+void MockMidiOutput::SendMsg(MIDI_event_t* msg, int frame_offset) {
+    if (!msg) return;
+    wire.deliver(msg->midi_message, msg->size);
+}
+
+void MockMidiOutput::Send(unsigned char status, unsigned char d1, unsigned char d2, int frame_offset) {
+    const unsigned char msg[3] = { status, d1, d2 };
+    wire.deliver(msg, 3);
+}
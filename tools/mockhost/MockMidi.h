@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include "reaKontrol.h"
+
+// Event list handed out by MockMidiInput::GetReadBuf(). Every event owns its own buffer so that
+// SysEx messages of any length survive until the next SwapBufs().
+class MockMidiEventList : public MIDI_eventlist {
+public:
+    virtual ~MockMidiEventList() {}
+
+    virtual void AddItem(MIDI_event_t* evt) override;
+    virtual MIDI_event_t* EnumItems(int* bpos) override;
+    virtual void DeleteItem(int bpos) override;
+    virtual int GetSize() override;
+    virtual void Empty() override;
+
+    void addMessage(const unsigned char* msg, int size);
+
+private:
+    std::vector<std::vector<unsigned char>> events;
+};
+
+// The "cable" between the plugin and a simulated keyboard. The wire outlives the midi_Input / midi_Output
+// objects the plugin creates and deletes, so a simulator can stay attached across reconnects.
+class MockMidiWire {
+public:
+    using OutputListener = std::function<void(const unsigned char* msg, int size)>;
+    using PlugListener = std::function<void(bool plugged)>;
+
+    // Device -> plugin: queued until the plugin swaps its input buffers
+    void inject(const unsigned char* msg, int size);
+    void injectCc(unsigned char status, unsigned char d1, unsigned char d2);
+
+    // Plugin -> device
+    void setOutputListener(OutputListener listener);
+    void deliver(const unsigned char* msg, int size);
+
+    // Unplugged, nothing passes the wire in either direction
+    void setPlugged(bool isPlugged);
+    bool plugged() const { return isPlugged; }
+    void setPlugListener(PlugListener listener);
+
+    void swapInto(MockMidiEventList& list);
+    bool hasPending() const { return !pending.empty(); }
+
+    int openInputs = 0;
+    int openOutputs = 0;
+    bool inputRunning = false;
+
+private:
+    std::deque<std::vector<unsigned char>> pending;
+    OutputListener listener;
+    PlugListener plugListener;
+    bool isPlugged = true;
+};
+
+class MockMidiInput : public midi_Input {
+public:
+    explicit MockMidiInput(MockMidiWire& wire);
+    virtual ~MockMidiInput();
+
+    virtual void start() override;
+    virtual void stop() override;
+    virtual void SwapBufs(unsigned int timestamp) override;
+    virtual MIDI_eventlist* GetReadBuf() override;
+
+private:
+    MockMidiWire& wire;
+    MockMidiEventList readBuf;
+};
+
+class MockMidiOutput : public midi_Output {
+public:
+    explicit MockMidiOutput(MockMidiWire& wire);
+    virtual ~MockMidiOutput();
+
+    virtual void SendMsg(MIDI_event_t* msg, int frame_offset) override;
+    virtual void Send(unsigned char status, unsigned char d1, unsigned char d2, int frame_offset) override;
+
+private:
+    MockMidiWire& wire;
+};
@@ -0,0 +1,189 @@
+/*
+ * ReaKontrol
+ * kkreplay: feeds a captured MIDI session (see "ReaKontrol: Toggle MIDI Session Capture") back through NiMidiSurface
+ * against the mock host at maximum speed and reports throughput, per-event latency and output differences.
+ * A capture with several keyboards holds one stream per surface, only the one given with --surface (default 0) is
+ * replayed.
+ *
+ * Usage: kkreplay <trace> [--tracks <n>] [--protocol <v>] [--repeat <n>] [--max-diffs <n>] [--surface <n>]
+ *
+ * Exit code: 0 = replayed output matches the capture, 1 = output differs, 2 = usage / load error
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "MockHost.h"
+#include "KkSimulator.h"
+#include "MidiTrace.h"
+
+namespace {
+    struct Options {
+        const char* trace = nullptr;
+        int tracks = 16;
+        int protocol = 4;
+        int repeat = 1;
+        int maxDiffs = 10;
+        int surface = 0;
+    };
+
+    bool parseOptions(int argc, char** argv, Options& opt) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.compare(0, 2, "--") != 0) {
+                opt.trace = argv[i];
+                continue;
+            }
+            if (i + 1 >= argc) return false;
+            int value = atoi(argv[++i]);
+            if (arg == "--tracks") opt.tracks = value;
+            else if (arg == "--protocol") opt.protocol = value;
+            else if (arg == "--repeat") opt.repeat = std::max(1, value);
+            else if (arg == "--max-diffs") opt.maxDiffs = value;
+            else if (arg == "--surface" && value >= 0 && value <= 255) opt.surface = value;
+            else return false;
+        }
+        return opt.trace != nullptr;
+    }
+
+    std::string hex(const std::vector<unsigned char>& msg) {
+        std::string s;
+        char buf[4];
+        for (unsigned char b : msg) {
+            snprintf(buf, sizeof(buf), "%02X ", b);
+            s += buf;
+        }
+        if (!s.empty()) s.pop_back();
+        return s;
+    }
+
+    double percentile(std::vector<double>& samples, double p) {
+        if (samples.empty()) return 0.0;
+        size_t idx = static_cast<size_t>(p * (samples.size() - 1) + 0.5);
+        std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+        return samples[idx];
+    }
+
+    bool connect(MockHost& host, int protocol) {
+        // Let the virtual keyboard do the handshake, the trace usually starts on an already connected surface
+        KkSimulator kk(host.wire(), protocol);
+        for (int i = 0; i < 1000 && !kk.display().connected; ++i) {
+            host.tick();
+        }
+        host.tick(2);
+        return kk.display().connected;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        fprintf(stderr, "Usage: kkreplay <trace> [--tracks <n>] [--protocol <v>] [--repeat <n>] [--max-diffs <n>] [--surface <n>]\n");
+        return 2;
+    }
+
+    std::vector<MidiTraceRecord> records;
+    if (!readMidiTrace(opt.trace, records)) {
+        fprintf(stderr, "kkreplay: %s is not a ReaKontrol MIDI trace\n", opt.trace);
+        return 2;
+    }
+    int numSurfaces = 0;
+    for (const MidiTraceRecord& r : records) {
+        numSurfaces = std::max(numSurfaces, r.surface + 1);
+    }
+    filterMidiTrace(records, static_cast<unsigned char>(opt.surface));
+    if (records.empty()) {
+        fprintf(stderr, "kkreplay: %s has no records of surface %d\n", opt.trace, opt.surface);
+        return 2;
+    }
+
+    MockHost& host = MockHost::get();
+    host.setTrackCount(opt.tracks);
+    if (!host.load() || !connect(host, opt.protocol)) {
+        fprintf(stderr, "kkreplay: unable to load and connect the plugin\n");
+        return 2;
+    }
+
+    std::vector<std::vector<unsigned char>> replayed;
+    host.wire().setOutputListener([&replayed](const unsigned char* msg, int size) {
+        replayed.emplace_back(msg, msg + size);
+    });
+
+    std::vector<std::vector<unsigned char>> expected;
+    for (const MidiTraceRecord& r : records) {
+        if (r.type == TRACE_OUT) expected.push_back(r.msg);
+    }
+
+    long long ticks = 0;
+    long long events = 0;
+    std::vector<double> latencyUs;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int pass = 0; pass < opt.repeat; ++pass) {
+        // Ticks run at their captured time on the host's virtual clock, so the plugin's timers fire as they did live
+        uint64_t passStart = host.now() + host.msPerTick;
+        size_t i = 0;
+        while (i < records.size()) {
+            // A tick record is followed by the inbound events that Run() processed in that tick
+            if (records[i].type != TRACE_TICK) {
+                ++i;
+                continue;
+            }
+            uint64_t tickTime = passStart + records[i].timeUs / 1000;
+            int inTick = 0;
+            for (++i; i < records.size() && records[i].type != TRACE_TICK; ++i) {
+                if (records[i].type == TRACE_IN) {
+                    host.wire().inject(records[i].msg.data(), static_cast<int>(records[i].msg.size()));
+                    ++inTick;
+                }
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            host.tickAt(tickTime);
+            auto t1 = std::chrono::steady_clock::now();
+            double us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+            for (int e = 0; e < inTick; ++e) {
+                latencyUs.push_back(us);
+            }
+            events += inTick;
+            ++ticks;
+        }
+        if (pass == 0) {
+            host.wire().setOutputListener([&replayed](const unsigned char*, int) {});
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t recordedIn = events / opt.repeat;
+
+    printf("trace        %s\n", opt.trace);
+    printf("surface      %d of %d\n", opt.surface, numSurfaces);
+    printf("ticks        %lld (%d pass%s)\n", ticks, opt.repeat, opt.repeat > 1 ? "es" : "");
+    printf("inbound      %zu events per pass\n", recordedIn);
+    printf("outbound     %zu recorded, %zu replayed\n", expected.size(), replayed.size());
+    printf("wall time    %.3f s\n", seconds);
+    printf("throughput   %.0f ticks/s, %.0f events/s\n", seconds > 0 ? ticks / seconds : 0.0, seconds > 0 ? events / seconds : 0.0);
+    printf("latency      p50 %.1f us, p99 %.1f us, max %.1f us\n",
+        percentile(latencyUs, 0.5), percentile(latencyUs, 0.99), latencyUs.empty() ? 0.0 : *std::max_element(latencyUs.begin(), latencyUs.end()));
+
+    // Output diff of the first pass, message by message
+    int diffs = 0;
+    size_t n = std::max(expected.size(), replayed.size());
+    for (size_t m = 0; m < n; ++m) {
+        const std::vector<unsigned char>* want = (m < expected.size()) ? &expected[m] : nullptr;
+        const std::vector<unsigned char>* got = (m < replayed.size()) ? &replayed[m] : nullptr;
+        if (want && got && *want == *got) continue;
+        if (diffs < opt.maxDiffs) {
+            printf("diff #%zu\n  recorded: %s\n  replayed: %s\n", m,
+                want ? hex(*want).c_str() : "(none)", got ? hex(*got).c_str() : "(none)");
+        }
+        ++diffs;
+    }
+    printf("differences  %d\n", diffs);
+
+    host.unload();
+    return diffs ? 1 : 0;
+}